@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "analysis_cache.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ANALYSIS_CACHE_MAGIC 0x4E414D41u  // "AMAN"
+#define ANALYSIS_CACHE_VERSION 3
+
+// Fixed header at the start of a sidecar, stored in native byte order (a
+// foreign byte order fails the magic check). The beat positions (Sint64)
+// follow at an 8-byte aligned offset, then the peak pyramid's levels in
+// waveform_pyramid_layout order, so both can be used in place from the
+// mapping.
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Sint64 source_size;
+    Sint64 source_mtime;
+    Uint64 content_hash;
+    Uint64 params_hash;
+    double tempo_bpm;
+    Sint64 beat_count;
+    Sint64 peak_frames;     // Frames the pyramid covers, 0 for none
+} AnalysisHeader;
+
+#define ALIGN8(x) (((x) + 7) & ~(Uint64)7)
+
+typedef struct {
+    Uint64 beats;
+    Uint64 peaks;
+    Uint64 end;
+    Sint64 peak_counts[WAVEFORM_PYRAMID_MAX_LEVELS];
+    int peak_levels;
+} SidecarLayout;
+
+static bool compute_layout(const AnalysisHeader *header, SidecarLayout *layout) {
+    // Reject counts that would overflow the offsets below
+    const Sint64 max_count = (Sint64)1 << 40;
+    if (header->beat_count < 0 || header->beat_count > max_count ||
+        header->peak_frames < 0 || header->peak_frames > max_count) {
+        return false;
+    }
+
+    const Sint64 peak_entries = waveform_pyramid_layout(header->peak_frames,
+                                                        layout->peak_counts,
+                                                        &layout->peak_levels);
+    layout->beats = ALIGN8(sizeof(AnalysisHeader));
+    layout->peaks = ALIGN8(layout->beats + (Uint64)header->beat_count * sizeof(Sint64));
+    layout->end = layout->peaks + (Uint64)peak_entries * sizeof(WaveformPeak);
+    return true;
+}
+
+static void sidecar_name(const PcmCacheKey *key, Uint64 params_hash,
+                         char *out, size_t out_size) {
+    snprintf(out, out_size, "%s-%016" SDL_PRIx64 ".ana", key->id, params_hash);
+}
+
+AnalysisData* analysis_cache_load(const PcmCacheKey *key, Uint64 params_hash) {
+    char file_name[64];
+    char path[1024];
+    sidecar_name(key, params_hash, file_name, sizeof(file_name));
+    if (!pcm_cache_path(file_name, path, sizeof(path))) return NULL;
+
+    MappedFile *map = mapped_file_open(path);
+    if (!map) return NULL;
+
+    AnalysisHeader header;
+    SidecarLayout layout;
+    bool valid = map->size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, map->data, sizeof(header));
+        valid = header.magic == ANALYSIS_CACHE_MAGIC &&
+                header.version == ANALYSIS_CACHE_VERSION &&
+                header.source_size == key->size &&
+                header.source_mtime == key->mtime &&
+                header.content_hash == key->content_hash &&
+                header.params_hash == params_hash &&
+                compute_layout(&header, &layout) &&
+                layout.end <= map->size;
+    }
+
+    AnalysisData *analysis = valid ? SDL_calloc(1, sizeof(AnalysisData)) : NULL;
+    if (!analysis) {
+        mapped_file_close(map);
+        return NULL;
+    }
+
+    const Uint8 *base = (const Uint8 *)map->data;
+    analysis->tempo_bpm = header.tempo_bpm;
+    analysis->beats = (Sint64 *)(base + layout.beats);
+    analysis->beat_count = header.beat_count;
+    waveform_pyramid_wrap(&analysis->peaks, (const WaveformPeak *)(base + layout.peaks),
+                          header.peak_frames);
+    analysis->map = map;
+
+    pcm_cache_record(file_name, -1);
+    return analysis;
+}
+
+// Write the complete entries of each level of `peaks`. The last entry of a
+// level may be partial; it is written as zeros and never read.
+static bool write_peaks(SDL_IOStream *io, const WaveformPyramid *peaks,
+                        const SidecarLayout *layout) {
+    static const WaveformPeak empty = {0};
+    for (int level = 0; level < layout->peak_levels; level++) {
+        const Sint64 complete = peaks->frames / ((Sint64)WAVEFORM_PEAK_BLOCK << level);
+        const size_t bytes = (size_t)complete * sizeof(WaveformPeak);
+        if (complete > 0 && SDL_WriteIO(io, peaks->levels[level], bytes) != bytes) {
+            return false;
+        }
+        for (Sint64 i = complete; i < layout->peak_counts[level]; i++) {
+            if (SDL_WriteIO(io, &empty, sizeof(empty)) != sizeof(empty)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool write_section(SDL_IOStream *io, const void *data, Uint64 bytes, Uint64 padded_end) {
+    static const Uint8 zeros[8] = {0};
+    if (bytes > 0 && SDL_WriteIO(io, data, (size_t)bytes) != bytes) {
+        return false;
+    }
+    Sint64 padding = (Sint64)padded_end - SDL_TellIO(io);
+    return padding >= 0 && padding < 8 &&
+           SDL_WriteIO(io, zeros, (size_t)padding) == (size_t)padding;
+}
+
+bool analysis_cache_store(const PcmCacheKey *key, Uint64 params_hash,
+                          const AnalysisData *analysis, const WaveformPyramid *peaks) {
+    if (!key || !analysis) return false;
+
+    AnalysisHeader header;
+    SDL_zero(header);
+    header.magic = ANALYSIS_CACHE_MAGIC;
+    header.version = ANALYSIS_CACHE_VERSION;
+    header.source_size = key->size;
+    header.source_mtime = key->mtime;
+    header.content_hash = key->content_hash;
+    header.params_hash = params_hash;
+    header.tempo_bpm = analysis->tempo_bpm;
+    header.beat_count = analysis->beat_count;
+    header.peak_frames = peaks && peaks->level_count > 0 ? peaks->frames : 0;
+
+    SidecarLayout layout;
+    if (!compute_layout(&header, &layout)) return false;
+
+    char file_name[64];
+    char path[1024];
+    char tmp_path[1024];
+    sidecar_name(key, params_hash, file_name, sizeof(file_name));
+    if (!pcm_cache_path(file_name, path, sizeof(path))) return false;
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%" SDL_PRIu64 ".tmp", path,
+             (Uint64)SDL_GetCurrentThreadID());
+
+    SDL_IOStream *io = SDL_IOFromFile(tmp_path, "wb");
+    if (!io) return false;
+
+    bool ok = write_section(io, &header, sizeof(header), layout.beats) &&
+              write_section(io, analysis->beats,
+                            (Uint64)analysis->beat_count * sizeof(Sint64), layout.peaks) &&
+              (header.peak_frames == 0 || write_peaks(io, peaks, &layout));
+    ok = SDL_CloseIO(io) && ok;
+
+    if (!ok || !SDL_RenamePath(tmp_path, path)) {
+        SDL_RemovePath(tmp_path);
+        return false;
+    }
+
+    pcm_cache_record(file_name, (Sint64)layout.end);
+    return true;
+}
+
+void analysis_data_free(AnalysisData *analysis) {
+    if (!analysis) return;
+
+    if (analysis->map) {
+        mapped_file_close(analysis->map);
+    } else {
+        SDL_free(analysis->beats);
+    }
+    SDL_free(analysis);
+}
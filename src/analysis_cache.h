@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+#include "mapped_file.h"
+#include "pcm_cache.h"
+#include "waveform_pyramid.h"
+
+// Everything derived from a file by analysis. Once published it is never
+// modified, so readers can use it without locking.
+typedef struct {
+    double tempo_bpm;
+    Sint64 *beats;              // Frame positions
+    Sint64 beat_count;
+    WaveformPyramid peaks;      // Peaks of the whole file when loaded from a
+                                // sidecar (level_count 0 if it had none)
+    MappedFile *map;            // When loaded from a sidecar, the arrays point
+                                // into this read-only mapping
+} AnalysisData;
+
+// Analysis sidecars sit next to the PCM cache entries and share their LRU
+// budget. An entry is only used if the source file (see PcmCacheKey) and
+// `params_hash`, which covers every setting that affects the result, both
+// match. Loading maps the file instead of reading it. `peaks`, the finished
+// peak pyramid of the file (or NULL), is stored along with the analysis so
+// the waveform can be drawn from it on the next open.
+AnalysisData* analysis_cache_load(const PcmCacheKey *key, Uint64 params_hash);
+bool analysis_cache_store(const PcmCacheKey *key, Uint64 params_hash,
+                          const AnalysisData *analysis, const WaveformPyramid *peaks);
+
+void analysis_data_free(AnalysisData *analysis);
+
+#endif // ANALYSIS_CACHE_H
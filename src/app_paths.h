@@ -0,0 +1,27 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef APP_PATHS_H
+#define APP_PATHS_H
+
+// Organisation and application names passed to SDL_GetPrefPath. Settings,
+// the PCM cache and analysis sidecars all live under that directory.
+#define UPDATER_ORG "acrilique"
+#define UPDATER_APP "automarker-c"
+
+#endif // APP_PATHS_H
@@ -26,6 +26,8 @@
 #include "connections/curl_manager.h"
 #include "connections/premiere_pro.h"
 #include "updater.h"
+#include "ui/icon_atlas.h"
+#include "ui/perf_hud.h"
 
 typedef struct {
   float zoom;   // Zoom level (1.0 = normal)
@@ -56,6 +58,24 @@ typedef enum {
   INTERACTION_DRAGGING_SCROLLBAR
 } WaveformInteractionState;
 
+// Everything on screen that can change without an SDL event: background
+// loads, playback, network replies and the app status thread. Compared
+// against the last drawn copy to decide whether a frame is needed.
+typedef struct {
+  AudioStatus audio_status;
+  int progress_permille;
+  Sint64 decoded_frames;
+  int beat_count;
+  PlaybackState playback_state;
+  Sint64 playback_position;
+  int connected_app;
+  int cep_health_status;
+  int cep_install_status;
+  UpdateStatus update_status;
+  int download_permille;
+  int requests_in_flight;
+} RedrawSnapshot;
+
 // Forward declaration
 typedef struct app_state AppState;
 
@@ -70,14 +90,7 @@ struct app_state {
   SDL_AtomicInt connected_app;
   SDL_AtomicInt should_stop_app_status_thread;
   SDL_Thread *app_status_thread;
-  SDL_Surface *file_icon;
-  SDL_Surface *play_icon;
-  SDL_Surface *send_icon;
-  SDL_Surface *remove_icon;
-  SDL_Surface *help_icon;
-  SDL_Surface *update_icon;
-  SDL_Surface *mark_in_icon;
-  SDL_Surface *mark_out_icon;
+  IconAtlas icons;
 
   Clay_SDL3RendererData rendererData;
   AudioState *audio_state;
@@ -90,7 +103,7 @@ struct app_state {
   bool is_hovering_selection_start;
   bool is_hovering_selection_end;
   bool is_selection_dragging;
-  unsigned int selection_drag_start;
+  Sint64 selection_drag_start;
   Clay_BoundingBox waveform_bbox;
   bool is_hovering_scrollbar_thumb;
   float scrollbar_drag_start_x;
@@ -105,6 +118,7 @@ struct app_state {
   ModalState modal;
 
   WaveformData waveformData;
+  PcmBuffer *waveform_pcm;  // Audio referenced by waveformData.samples
   CurlManager *curl_manager;
   UpdaterState *updater_state;
   CepInstallState cep_install_state;
@@ -113,6 +127,13 @@ struct app_state {
   Uint64 cep_health_last_check_time;   // When we last sent a health check
   int cep_health_retry_count;          // Number of retries attempted
 
+  // Redraw scheduling, see SDL_AppIterate
+  int pending_frames;             // Frames still to draw, set by events
+  RedrawSnapshot last_drawn;
+  Uint64 last_frame_ticks;
+
+  PerfHud perf_hud;               // F3 overlay
+
   // Clay memory buffer (must be freed on shutdown)
   void *clayMemoryBuffer;
 };
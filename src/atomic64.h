@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATOMIC64_H
+#define ATOMIC64_H
+
+#include <SDL3/SDL.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// 64-bit counterpart of SDL_AtomicInt, which SDL3 does not provide.
+// Used for frame positions, which don't fit in 32 bits on long recordings.
+typedef struct {
+    volatile Sint64 value;
+} AtomicS64;
+
+static inline Sint64 atomic_s64_get(AtomicS64 *a) {
+#ifdef _MSC_VER
+    return _InterlockedCompareExchange64((volatile __int64 *)&a->value, 0, 0);
+#else
+    return __atomic_load_n(&a->value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline void atomic_s64_set(AtomicS64 *a, Sint64 v) {
+#ifdef _MSC_VER
+    Sint64 old = a->value;
+    Sint64 seen;
+    while ((seen = _InterlockedCompareExchange64((volatile __int64 *)&a->value, v, old)) != old) {
+        old = seen;
+    }
+#else
+    __atomic_store_n(&a->value, v, __ATOMIC_SEQ_CST);
+#endif
+}
+
+#endif // ATOMIC64_H
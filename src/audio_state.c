@@ -17,321 +17,1185 @@
 
 #include "audio_state.h"
 #include "SDL3/SDL_atomic.h"
+#include "dsp/convert.h"
+#include "fnv1a.h"
+#include "pcm_cache.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Desired audio format (moved from main.c)
+// Desired audio format (moved from main.c). Everything is left at 0 so the
+// file is decoded in its native format, layout and rate: playback needs no
+// resampling, and the conversion to float goes through our own kernels.
 static Sound_AudioInfo desired = {
+    .format = 0,
+    .channels = 0,
+    .rate = 0,
+};
+
+// Used instead when the native sample format has no conversion kernel
+// (8-bit or byte-swapped data); SDL_sound converts to float for us
+static Sound_AudioInfo desired_f32 = {
     .format = SDL_AUDIO_F32,
-    .channels = 2,
-    .rate = 44100,
+    .channels = 0,
+    .rate = 0,
 };
 
-// Convert SDL_Sound sample to CARA audio_data structure
-audio_data* sdl_sound_to_cara_audio(Sound_Sample *sample) {
-    if (!sample || !sample->buffer || sample->buffer_size == 0) {
-        return NULL;
+// Beat tracking only needs a mono signal at about this rate. Higher-rate
+// files are downmixed and decimated by an integer factor before analysis.
+#define ANALYSIS_TARGET_RATE 22050
+
+// CARA beat tracking parameters
+#define BEAT_WINDOW_SIZE 2048
+#define BEAT_HOP_LENGTH 512
+#define BEAT_N_MELS 128
+
+// Size of each Sound_Decode call. Every chunk is published to the UI as soon
+// as it is decoded, so this also sets the waveform's refresh granularity.
+#define DECODE_CHUNK_BYTES (256 * 1024)
+
+// Capacity used when the decoder cannot report a duration (one minute)
+#define DECODE_FALLBACK_SECONDS 60
+
+// Analysis samples produced per downmix/decimate pass
+#define ANALYSIS_BLOCK 1024
+
+// Share of the progress bar taken by each stage of a load that has to run
+// the beat analysis. CARA reports nothing until it returns, so the beat
+// tracking share fills in one step; the stages before it are ours and
+// report as they go. Loads with a cached analysis give decoding the whole bar.
+#define PROGRESS_DECODE_END 0.40f
+#define PROGRESS_SIGNAL_END 0.45f
+
+// Bump when the way the analysis is derived from CARA's result changes
+#define ANALYSIS_FORMAT_VERSION 2
+
+#ifndef CARA_REVISION
+#define CARA_REVISION "unknown"
+#endif
+
+// Time audio_state_destroy gives cancelled jobs to wind down
+#define JOB_SHUTDOWN_TIMEOUT_MS 2000
+
+// How often a job queued behind another one's beat tracking checks whether
+// it has been cancelled
+#define ANALYSIS_WAIT_POLL_MS 10
+
+// One file load, run on its own detached thread. Loading another file, or
+// stopping, cancels the job instead of waiting for it: a job stuck in
+// beat_track_audio (which can't be interrupted) keeps running in the
+// background, but from the moment it is cancelled it no longer writes to
+// the AudioState and only cleans up after itself. Only one job at a time
+// runs beat_track_audio (see acquire_analysis), so loading file after file
+// can't pile up analyses that are going to be thrown away.
+struct ProcessingJob {
+  AudioState *state;
+  char *file_path;
+  SDL_AtomicInt cancel;
+  PcmBuffer *pcm;           // The job's own reference to the buffer it fills
+  Sound_Sample *sample;     // Opened by the caller, decoded from on a cache miss
+  float progress_start;     // Range of processing_progress for the current stage
+  float progress_end;
+};
+
+static bool job_cancelled(ProcessingJob *job) {
+  return SDL_GetAtomicInt(&job->cancel) != 0;
+}
+
+// Lock the state on behalf of `job`. Returns false, without holding the
+// lock, if the job has been cancelled: it must leave the state alone.
+static bool lock_for_job(ProcessingJob *job) {
+  SDL_LockMutex(job->state->data_mutex);
+  if (job->state->job == job && !job_cancelled(job)) {
+    return true;
+  }
+  SDL_UnlockMutex(job->state->data_mutex);
+  return false;
+}
+
+static void set_stage(ProcessingJob *job, AudioStatus status, float start, float end,
+                      bool indeterminate) {
+  job->progress_start = start;
+  job->progress_end = end;
+  if (lock_for_job(job)) {
+    job->state->status = status;
+    job->state->processing_progress = start;
+    job->state->progress_indeterminate = indeterminate;
+    SDL_UnlockMutex(job->state->data_mutex);
+  }
+}
+
+// Start a stage covering [start, end] of the progress bar
+static void begin_stage(ProcessingJob *job, AudioStatus status, float start, float end) {
+  set_stage(job, status, start, end, false);
+}
+
+// Start a stage that can't report how far it is. The bar stays at `start`
+// and the UI shows it as busy until the stage ends at `end`.
+static void begin_opaque_stage(ProcessingJob *job, AudioStatus status, float start, float end) {
+  set_stage(job, status, start, end, true);
+}
+
+// Report how far (0..1) the current stage is
+static void report_progress(ProcessingJob *job, double fraction) {
+  if (fraction > 1.0) {
+    fraction = 1.0;
+  }
+  if (lock_for_job(job)) {
+    job->state->processing_progress = job->progress_start +
+        (float)fraction * (job->progress_end - job->progress_start);
+    SDL_UnlockMutex(job->state->data_mutex);
+  }
+}
+
+// Make room for at least `frames` frames in the job's buffer. Readers may
+// still hold the old buffer, so it is replaced rather than reallocated in
+// place.
+static bool reserve_pcm(ProcessingJob *job, Sint64 frames) {
+  if (frames <= job->pcm->capacity) {
+    return true;
+  }
+
+  PcmBuffer *grown = pcm_buffer_grow(job->pcm, frames);
+  if (!grown) {
+    return false;
+  }
+  job->pcm = grown;
+
+  // Playback may be reading the old buffer; the UI thread offers it this
+  // one (see follow_decoder)
+  if (lock_for_job(job)) {
+    AudioState *state = job->state;
+    PcmBuffer *previous = state->pcm;
+    state->pcm = pcm_buffer_retain(grown);
+    SDL_UnlockMutex(state->data_mutex);
+    pcm_buffer_release(previous);
+  }
+
+  return true;
+}
+
+// Make `pcm` the buffer being filled. The job keeps its own reference, so
+// the buffer outlives the state's if the job is cancelled meanwhile. The UI
+// thread opens playback on it as soon as it sees it (see follow_decoder),
+// so playback can start on the first published chunk.
+static void install_pcm(ProcessingJob *job, PcmBuffer *pcm, Sint64 expected_frames) {
+  job->pcm = pcm;
+  if (!lock_for_job(job)) {
+    return;
+  }
+  AudioState *state = job->state;
+  PcmBuffer *previous = state->pcm;
+  state->pcm = pcm_buffer_retain(pcm);
+  state->sample_rate = pcm->sample_rate;
+  state->channels = pcm->channels;
+  state->loaded_frames = expected_frames;
+  SDL_UnlockMutex(state->data_mutex);
+  pcm_buffer_release(previous);
+}
+
+// Open the PCM cache entry for the file and install an empty buffer for it.
+// If `analysis` came from a sidecar with the file's peaks, they are copied
+// in first, so the whole waveform is drawn before any audio is read back.
+// Returns NULL on a miss; the caller then decodes.
+static PcmCacheReader* open_cached_pcm(ProcessingJob *job, const PcmCacheKey *key,
+                                       const AnalysisData *analysis) {
+  PcmCacheReader *reader = pcm_cache_open(key);
+  if (!reader) {
+    return NULL;
+  }
+
+  PcmBuffer *pcm = pcm_buffer_create(reader->frames, reader->channels,
+                                     reader->sample_rate);
+  if (!pcm) {
+    pcm_cache_close(reader);
+    return NULL;
+  }
+  if (analysis && analysis->peaks.frames == reader->frames) {
+    waveform_pyramid_seed(&pcm->peaks, &analysis->peaks);
+  }
+  install_pcm(job, pcm, reader->frames);
+  return reader;
+}
+
+// Stream the audio back from the cache into the installed buffer, then
+// close `reader`. Returns false if the entry turns out to be damaged.
+static bool stream_cached_pcm(ProcessingJob *job, PcmCacheReader *reader) {
+  PcmBuffer *pcm = job->pcm;
+  Sint64 loaded = 0;
+  Sint64 frames;
+  while ((frames = pcm_cache_read(reader, pcm->samples + loaded * pcm->channels,
+                                  reader->frames - loaded)) > 0) {
+    if (job_cancelled(job)) {
+      break;
     }
-    
-    audio_data *audio = SDL_malloc(sizeof(audio_data));
-    if (!audio) return NULL;
-    
-    // Calculate number of samples
-    size_t sample_size = sizeof(float); // CARA expects float samples
-    size_t total_samples = sample->buffer_size / sample_size;
-    
-    // Allocate and copy sample data
-    audio->samples = SDL_malloc(sample->buffer_size);
-    if (!audio->samples) {
-        SDL_free(audio);
-        return NULL;
+    loaded += frames;
+    pcm_buffer_publish(pcm, loaded);
+    report_progress(job, (double)loaded / (double)reader->frames);
+  }
+
+  bool complete = loaded == reader->frames;
+  pcm_cache_close(reader);
+  if (complete) {
+    printf("Loaded decoded audio from cache: %s\n", job->file_path);
+  }
+  return complete;
+}
+
+// Open the decoder in the file's native sample format, or in float if we
+// have no conversion kernel for it
+Sound_Sample* audio_state_open_sample(const char *file_path) {
+  Sound_Sample *sample =
+      Sound_NewSampleFromFile(file_path, &desired, DECODE_CHUNK_BYTES);
+  if (sample && !convert_is_supported(sample->actual.format)) {
+    Sound_FreeSample(sample);
+    sample = Sound_NewSampleFromFile(file_path, &desired_f32, DECODE_CHUNK_BYTES);
+  }
+  if (!sample) {
+    printf("Error: Could not open audio file: %s\n", file_path);
+  }
+  return sample;
+}
+
+// Decode the whole file chunk by chunk, publishing each decoded region
+static bool decode_audio_file(ProcessingJob *job, Sound_Sample *sample) {
+  const SDL_AudioFormat format = sample->actual.format;
+  const int channels = sample->actual.channels;
+  const int rate = (int)sample->actual.rate;
+  const size_t sample_bytes = SDL_AUDIO_BYTESIZE(format);
+
+  // Pre-size the destination from the reported duration so the common case
+  // never reallocates. Some decoders (e.g. VBR MP3 without a header) can't
+  // tell, or get it slightly wrong; reserve_pcm grows the buffer if needed.
+  Sint32 duration_ms = Sound_GetDuration(sample);
+  Sint64 expected_frames = duration_ms > 0
+      ? (Sint64)duration_ms * rate / 1000
+      : (Sint64)DECODE_FALLBACK_SECONDS * rate;
+
+  const Sint64 chunk_frames = DECODE_CHUNK_BYTES / (channels * (Sint64)sample_bytes);
+  PcmBuffer *pcm = pcm_buffer_create(expected_frames + chunk_frames, channels, rate);
+  if (!pcm) {
+    printf("Error: Could not allocate decode buffer for %s\n", job->file_path);
+    return false;
+  }
+  install_pcm(job, pcm, expected_frames);
+
+  size_t decoded = 0;
+  while (!(sample->flags & (SOUND_SAMPLEFLAG_EOF | SOUND_SAMPLEFLAG_ERROR))) {
+    if (job_cancelled(job)) {
+      return false;
     }
-    
-    memcpy(audio->samples, sample->buffer, sample->buffer_size);
-    
-    // Set audio properties
-    audio->num_samples = total_samples;
-    audio->channels = sample->actual.channels;
-    audio->sample_rate = sample->actual.rate;
-    audio->file_size = sample->buffer_size;
-    
-    return audio;
+
+    Uint32 decoded_bytes = Sound_Decode(sample);
+    if (decoded_bytes == 0) {
+      if (sample->flags & SOUND_SAMPLEFLAG_EAGAIN) {
+        continue;
+      }
+      break;
+    }
+
+    size_t chunk_samples = decoded_bytes / sample_bytes;
+    if (!reserve_pcm(job, (Sint64)((decoded + chunk_samples) / channels))) {
+      printf("Error: Could not grow decode buffer for %s\n", job->file_path);
+      return false;
+    }
+    convert_to_f32(format, sample->buffer, job->pcm->samples + decoded, chunk_samples);
+    decoded += chunk_samples;
+    Sint64 decoded_frames = (Sint64)(decoded / channels);
+
+    // Publish the new region only after its samples are written
+    pcm_buffer_publish(job->pcm, decoded_frames);
+
+    if (decoded_frames > expected_frames) {
+      expected_frames = decoded_frames;
+    }
+    if (lock_for_job(job)) {
+      job->state->loaded_frames = expected_frames;
+      SDL_UnlockMutex(job->state->data_mutex);
+    }
+    report_progress(job, (double)decoded_frames / (double)expected_frames);
+  }
+
+  if (lock_for_job(job)) {
+    job->state->loaded_frames = (Sint64)(decoded / channels);
+    SDL_UnlockMutex(job->state->data_mutex);
+  }
+  report_progress(job, 1.0);
+
+  return decoded > 0;
 }
 
-// Free CARA audio_data structure
-void free_cara_audio(audio_data *audio) {
-    if (!audio) return;
-    
-    if (audio->samples) {
-        SDL_free(audio->samples);
+// Release the decoded audio and everything derived from it. The caller
+// must have cancelled the processing job and stopped the audio callback.
+static void release_pcm(AudioState *state) {
+  SDL_LockMutex(state->data_mutex);
+  pcm_buffer_release(state->pcm);
+  state->pcm = NULL;
+  state->loaded_frames = 0;
+  SDL_UnlockMutex(state->data_mutex);
+  state->total_frames = 0;
+  state->selection_start = 0;
+  state->selection_end = 0;
+  state->selection_user_set = false;
+
+  pcm_buffer_release(state->playback_pcm);
+  state->playback_pcm = NULL;
+  pcm_buffer_release(state->offered_pcm);
+  state->offered_pcm = NULL;
+  pcm_buffer_release(SDL_SetAtomicPointer((void **)&state->incoming_pcm, NULL));
+  pcm_buffer_release(SDL_SetAtomicPointer((void **)&state->retired_pcm, NULL));
+  scrub_engine_free(&state->scrub);
+}
+
+// Build the mono, decimated signal used for beat tracking. Frames are
+// downmixed to mono, then each run of `factor` samples is averaged, which
+// doubles as a cheap anti-aliasing filter. Returns the decimation factor,
+// or 0 on allocation failure or cancellation. When no conversion is needed the PCM is borrowed as is and
+// *owned is set to false.
+static int make_analysis_signal(ProcessingJob *job, audio_data *out, bool *owned) {
+  PcmBuffer *pcm = job->pcm;
+  const int channels = pcm->channels;
+  const Sint64 frames = pcm_buffer_frames(pcm);
+
+  int factor = pcm->sample_rate / ANALYSIS_TARGET_RATE;
+  if (factor < 1) {
+    factor = 1;
+  }
+
+  if (channels == 1 && factor == 1) {
+    *out = (audio_data){
+      .samples = pcm->samples,
+      .num_samples = (size_t)frames,
+      .channels = 1,
+      .sample_rate = pcm->sample_rate,
+      .file_size = (size_t)frames * sizeof(float),
+    };
+    *owned = false;
+    return factor;
+  }
+
+  const size_t out_len = (size_t)(frames / factor);
+  float *mono = SDL_malloc(out_len * sizeof(float));
+  // Full-rate mono only ever exists one block at a time
+  float *block = SDL_malloc((size_t)ANALYSIS_BLOCK * factor * sizeof(float));
+  if (!mono || !block) {
+    SDL_free(mono);
+    SDL_free(block);
+    return 0;
+  }
+
+  for (size_t i = 0; i < out_len; i += ANALYSIS_BLOCK) {
+    // Poll for cancellation and report progress every 64 blocks
+    if ((i / ANALYSIS_BLOCK) % 64 == 0) {
+      if (job_cancelled(job)) {
+        break;
+      }
+      report_progress(job, (double)i / (double)out_len);
+    }
+    const size_t count = out_len - i < ANALYSIS_BLOCK ? out_len - i : ANALYSIS_BLOCK;
+    const float *src = pcm->samples + i * factor * channels;
+    convert_downmix_f32(src, block, count * factor, channels);
+    convert_decimate_f32(block, mono + i, count, factor);
+  }
+  SDL_free(block);
+  if (job_cancelled(job)) {
+    SDL_free(mono);
+    return 0;
+  }
+
+  *out = (audio_data){
+    .samples = mono,
+    .num_samples = out_len,
+    .channels = 1,
+    .sample_rate = pcm->sample_rate / factor,
+    .file_size = out_len * sizeof(float),
+  };
+  *owned = true;
+  return factor;
+}
+
+// Largest piece handed to SDL_PutAudioStreamData at once
+#define PLAYBACK_PIECE_BYTES 16384
+
+// Silence is queued from here, so the callback never allocates for it
+static const float playback_silence[PLAYBACK_PIECE_BYTES / sizeof(float)];
+
+static void put_silence(SDL_AudioStream *stream, int bytes) {
+    while (bytes > 0) {
+        const int piece = bytes < PLAYBACK_PIECE_BYTES ? bytes : PLAYBACK_PIECE_BYTES;
+        SDL_PutAudioStreamData(stream, playback_silence, piece);
+        bytes -= piece;
     }
-    SDL_free(audio);
 }
 
-// Audio callback function for SDL3 streaming
+// What fill_playback_stream managed to queue. Only FILL_SHORT is an xrun:
+// silence while stopped, for an empty loop region, while the decoder
+// catches up or while the ring refills after a jump is what the user asked
+// for or a wait for data that doesn't exist yet, not a glitch in the audio
+// path.
+typedef enum {
+    FILL_PLAYED,    // Everything asked for came from the ring
+    FILL_IDLE,      // Silence: not playing, or the loop region is empty
+    FILL_WAITING,   // Played what was there, then silence until the decoder or a refill catches up
+    FILL_SHORT      // Audio was due but didn't reach the stream: the feeder fell behind
+} FillResult;
+
+// Where a frame outside the loop region plays from. The feeder and the
+// callback wrap the same way, so their blocks line up.
+static Sint64 wrap_to_loop(Sint64 frame, Sint64 loop_start, Sint64 loop_end) {
+    return frame < loop_start || frame >= loop_end ? loop_start : frame;
+}
+
+// Tell the feeder what to read: from `frame` if `generation` is new,
+// wrapping in the callback's loop region
+static void publish_feed(AudioState *state, int generation, Sint64 frame) {
+    PlaybackFeed *feed = &state->feed;
+    SDL_AddAtomicInt(&feed->sequence, 1);
+    SDL_SetAtomicInt(&feed->generation, generation);
+    atomic_s64_set(&feed->frame, frame);
+    atomic_s64_set(&feed->loop_start, state->loop_start);
+    atomic_s64_set(&feed->loop_end, state->loop_end);
+    SDL_AddAtomicInt(&feed->sequence, 1);
+}
+
+// Restart the read-ahead at `frame`. What the ring holds now is dropped;
+// blocks the feeder finishes for the old request are skipped as they come.
+static void request_feed(AudioState *state, Sint64 frame) {
+    state->engine_feed_generation = state->engine_feed_generation % SDL_MAX_SINT32 + 1;
+    state->engine_feed_next = frame;
+    state->engine_feed_started = false;
+    while (playback_ring_front(&state->ring)) {
+        playback_ring_pop(&state->ring);
+    }
+    publish_feed(state, state->engine_feed_generation, frame);
+    SDL_SignalSemaphore(state->feeder_wake);
+}
+
+// Queue `bytes_needed` bytes of the loop region from the read-ahead ring.
+// Runs on the audio device thread, so it neither locks nor allocates; it
+// never touches the decoded buffer itself, only the ring's blocks, and
+// asks the feeder for a refill when the position left what they hold.
+// *first_frame is set to the first frame queued, or -1 if only silence was,
+// and *played to the number of frames queued from it before any silence.
+static FillResult fill_playback_stream(AudioState *state, SDL_AudioStream *stream,
+                                       int bytes_needed, Sint64 *first_frame,
+                                       Sint64 *played) {
+    *first_frame = -1;
+    *played = 0;
+    const Sint64 loop_start = state->loop_start;
+    const Sint64 loop_end = state->loop_end;
+    if (state->engine_state != PLAYBACK_PLAYING || loop_end <= loop_start) {
+        put_silence(stream, bytes_needed);
+        return FILL_IDLE;
+    }
+
+    const int frame_size = state->channels * (int)sizeof(float);
+    FillResult result = FILL_PLAYED;
+    bool consumed = false;
+    Sint64 frames_needed = bytes_needed / frame_size;
+    Sint64 current_frame = atomic_s64_get(&state->playback_position);
+    while (frames_needed > 0) {
+        current_frame = wrap_to_loop(current_frame, loop_start, loop_end);
+        PlaybackBlock *block = playback_ring_front(&state->ring);
+        if (block && block->generation != state->engine_feed_generation) {
+            playback_ring_pop(&state->ring); // Read for an earlier request
+            consumed = true;
+            continue;
+        }
+
+        if (!block) {
+            if (state->engine_feed_generation == 0 ||
+                wrap_to_loop(state->engine_feed_next, loop_start, loop_end) != current_frame) {
+                request_feed(state, current_frame);
+                result = FILL_WAITING;
+            } else if (!state->engine_feed_started ||
+                       SDL_GetAtomicInt(&state->starved_generation) == state->engine_feed_generation) {
+                result = FILL_WAITING;
+            } else {
+                result = FILL_SHORT;
+            }
+            put_silence(stream, (int)(frames_needed * frame_size));
+            break;
+        }
+        state->engine_feed_started = true;
+
+        // The ring went elsewhere, e.g. the loop moved after it was read
+        const Sint64 offset = current_frame - block->frame;
+        if (offset < 0 || offset >= block->frames) {
+            request_feed(state, current_frame);
+            continue;
+        }
+
+        if (*first_frame < 0) {
+            *first_frame = current_frame;
+        }
+        Sint64 frames = SDL_min(frames_needed, block->frames - offset);
+        frames = SDL_min(frames, loop_end - current_frame);
+        if (!SDL_PutAudioStreamData(stream, block->samples + offset * state->channels,
+                                    (int)(frames * frame_size))) {
+            result = FILL_SHORT;
+        }
+        current_frame += frames;
+        frames_needed -= frames;
+        *played += frames;
+
+        if (offset + frames >= block->frames) {
+            state->engine_feed_next = block->frame + block->frames;
+            playback_ring_pop(&state->ring);
+            consumed = true;
+        }
+    }
+
+    // Room for more: wake the feeder. Doesn't block.
+    if (consumed) {
+        SDL_SignalSemaphore(state->feeder_wake);
+    }
+    atomic_s64_set(&state->playback_position, current_frame);
+    return result;
+}
+
+// Queue scrub grains until the engine has finished or `bytes` are queued.
+// Returns the bytes queued. Like fill_playback_stream, neither locks nor
+// allocates: the engine renders into its own preallocated block.
+static int queue_scrub(AudioState *state, SDL_AudioStream *stream, int bytes) {
+    ScrubEngine *scrub = &state->scrub;
+    PcmBuffer *pcm = state->playback_pcm;
+    const float *samples = pcm ? pcm->samples : NULL;
+    const Sint64 available = pcm_buffer_frames(pcm);
+    const Sint64 target = atomic_s64_get(&state->scrub_target);
+    const int frame_size = state->channels * (int)sizeof(float);
+
+    int frames_needed = bytes / frame_size;
+    int queued = 0;
+    while (frames_needed > 0 && scrub_engine_active(scrub)) {
+        const int frames = scrub_engine_render(scrub, samples, available, target,
+                                               SDL_min(frames_needed, SCRUB_BLOCK_FRAMES));
+        if (frames <= 0) break;
+        SDL_PutAudioStreamData(stream, scrub->output, frames * frame_size);
+        queued += frames;
+        frames_needed -= frames;
+    }
+
+    if (!scrub_engine_active(scrub)) {
+        if (scrub->resume_frame >= 0) {
+            atomic_s64_set(&state->playback_position, scrub->resume_frame);
+        }
+        SDL_SetAtomicInt(&state->finished_scrub_serial, (int)state->engine_scrub_serial);
+    }
+    return queued * frame_size;
+}
+
+// Apply the UI's transport commands. Runs at the start of each pull, so a
+// change never lands in the middle of a buffer.
+static void apply_playback_commands(AudioState *state) {
+    PlaybackCommand command;
+    while (playback_queue_pop(&state->commands, &command)) {
+        switch (command.type) {
+            case PLAYBACK_CMD_SEEK:
+                atomic_s64_set(&state->playback_position, command.frame);
+                state->engine_seek_serial = command.serial;
+                request_feed(state, command.frame);
+                break;
+            case PLAYBACK_CMD_SET_LOOP:
+                // The feeder wraps at the new region from its next block on.
+                // Blocks it already read past the new end are caught by
+                // fill_playback_stream, which refills from there.
+                state->loop_start = command.frame;
+                state->loop_end = command.end;
+                publish_feed(state, state->engine_feed_generation,
+                             atomic_s64_get(&state->feed.frame));
+                break;
+            case PLAYBACK_CMD_PLAY:
+                state->engine_state = PLAYBACK_PLAYING;
+                state->engine_play_serial = command.serial;
+                break;
+            case PLAYBACK_CMD_PAUSE:
+                state->engine_state = PLAYBACK_PAUSED;
+                break;
+            case PLAYBACK_CMD_STOP:
+                state->engine_state = PLAYBACK_STOPPED;
+                scrub_engine_reset(&state->scrub);
+                SDL_SetAtomicInt(&state->finished_scrub_serial, (int)state->engine_scrub_serial);
+                break;
+            case PLAYBACK_CMD_SCRUB_BEGIN:
+                scrub_engine_start(&state->scrub, command.frame,
+                                   state->engine_state == PLAYBACK_PLAYING
+                                       ? atomic_s64_get(&state->playback_position) : -1);
+                state->engine_scrub_serial = command.serial;
+                break;
+            case PLAYBACK_CMD_SCRUB_END: {
+                // A handoff moves the position on once linear playback is
+                // back, one hop after the release (see scrub_engine_render);
+                // the ring is filled from there meanwhile
+                const bool handoff = state->engine_state == PLAYBACK_PLAYING &&
+                                     scrub_engine_active(&state->scrub);
+                atomic_s64_set(&state->playback_position, command.frame);
+                state->engine_seek_serial = command.serial;
+                scrub_engine_release(&state->scrub, command.frame, handoff);
+                request_feed(state, handoff ? command.frame + state->scrub.hop_frames
+                                            : command.frame);
+                break;
+            }
+        }
+    }
+}
+
+// Record that `frame` will be heard at `time_ns`, followed by `span` frames
+// of the loop region
+static void publish_playback_clock(AudioState *state, Sint64 frame, Sint64 span,
+                                   Uint64 time_ns) {
+    PlaybackClock *clock = &state->clock;
+    SDL_AddAtomicInt(&clock->sequence, 1);
+    atomic_s64_set(&clock->frame, frame);
+    atomic_s64_set(&clock->span, span);
+    atomic_s64_set(&clock->time_ns, (Sint64)time_ns);
+    atomic_s64_set(&clock->loop_start, state->loop_start);
+    atomic_s64_set(&clock->loop_end, state->loop_end);
+    SDL_SetAtomicInt(&clock->play_serial, (int)state->engine_play_serial);
+    SDL_AddAtomicInt(&clock->sequence, 1);
+}
+
+static Sint64 frames_to_ns(const AudioState *state, Sint64 frames) {
+    return frames * (Sint64)SDL_NS_PER_SECOND / SDL_max(state->sample_rate, 1);
+}
+
+// Audio callback function for SDL3 streaming. Only the bytes the device
+// needs right now are queued, so the stream never holds more than one pull
+// ahead of what is audible.
 static void audio_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount) {
-    (void)additional_amount;
     AudioState *state = (AudioState *)userdata;
-    
-    const int total_bytes_needed = total_amount;
+    if (!state || additional_amount <= 0) return;
+
+    const Uint64 started = SDL_GetTicksNS();
+    const int frame_size = state->channels * (int)sizeof(float);
 
-    if (!state || !state->playback_buffer || state->playback_state != PLAYBACK_PLAYING) {
-        Uint8* silence = SDL_calloc(1, total_bytes_needed);
-        if (silence) {
-            SDL_PutAudioStreamData(stream, silence, total_bytes_needed);
-            SDL_free(silence);
+    // Follow the decoder into a bigger buffer. The old one is left for the
+    // UI thread to release, and only once it has taken the previous one.
+    if (!SDL_GetAtomicPointer((void **)&state->retired_pcm)) {
+        PcmBuffer *incoming = SDL_SetAtomicPointer((void **)&state->incoming_pcm, NULL);
+        if (incoming) {
+            SDL_SetAtomicPointer((void **)&state->retired_pcm, state->playback_pcm);
+            state->playback_pcm = incoming;
         }
-        return;
     }
-    
-    int current_pos_samples = SDL_GetAtomicInt(&state->playback_position);
-    Uint8* temp_buffer = SDL_malloc(total_bytes_needed);
-    if (!temp_buffer) return;
-    int bytes_provided = 0;
-
-    while (bytes_provided < total_bytes_needed) {
-        if (current_pos_samples < (int)state->selection_start || current_pos_samples >= (int)state->selection_end) {
-            current_pos_samples = state->selection_start;
-        }
+    apply_playback_commands(state);
+
+    // Scrub grains first; if the scrub ends in this pull, linear playback
+    // picks up where its handoff left off
+    int scrubbed = 0;
+    if (scrub_engine_active(&state->scrub)) {
+        scrubbed = queue_scrub(state, stream, additional_amount);
+    }
+    Sint64 first_frame = -1;
+    Sint64 played = 0;
+    FillResult fill = FILL_IDLE;
+    if (scrubbed < additional_amount) {
+        fill = fill_playback_stream(state, stream, additional_amount - scrubbed,
+                                    &first_frame, &played);
+    }
+    const Uint64 elapsed = SDL_GetTicksNS() - started;
+
+    // What was already queued plays first, then the device buffer being
+    // filled now, which starts once the one playing has drained
+    if (first_frame >= 0) {
+        const Sint64 queued_frames = (total_amount - additional_amount + scrubbed) / frame_size;
+        publish_playback_clock(state, first_frame, played,
+                               started + frames_to_ns(state, queued_frames) + state->device_latency_ns);
+    }
+    // Published after the clock, so a reader that sees the seek applied
+    // also sees an anchor from after it
+    SDL_SetAtomicInt(&state->applied_seek_serial, (int)state->engine_seek_serial);
 
-        int samples_left_in_loop = (int)state->selection_end - current_pos_samples;
-        int bytes_left_in_loop = samples_left_in_loop * sizeof(float);
+    // Count an xrun when audio that was there didn't reach the stream, or
+    // when filling took longer than the audio it queued lasts. Waiting for
+    // the decoder and an empty loop region are not xruns (see FillResult).
+    const Uint64 budget_ns = (Uint64)(additional_amount / frame_size) * SDL_NS_PER_SECOND /
+                             (Uint64)SDL_max(state->sample_rate, 1);
+    if (fill == FILL_SHORT || (state->engine_state == PLAYBACK_PLAYING && elapsed > budget_ns)) {
+        SDL_AddAtomicInt(&state->xrun_count, 1);
+    }
 
-        int bytes_to_copy_this_iteration = total_bytes_needed - bytes_provided;
+    if (!SDL_GetAtomicInt(&state->callback_timing)) return;
 
-        if (bytes_to_copy_this_iteration > bytes_left_in_loop) {
-            bytes_to_copy_this_iteration = bytes_left_in_loop;
+    const int elapsed_ns = elapsed > SDL_MAX_SINT32 ? SDL_MAX_SINT32 : (int)elapsed;
+    SDL_SetAtomicInt(&state->callback_last_ns, elapsed_ns);
+    int peak = SDL_GetAtomicInt(&state->callback_peak_ns);
+    while (elapsed_ns > peak &&
+           !SDL_CompareAndSwapAtomicInt(&state->callback_peak_ns, peak, elapsed_ns)) {
+        peak = SDL_GetAtomicInt(&state->callback_peak_ns);
+    }
+}
+
+// How often the feeder looks for more decoded audio once it has read
+// everything the decoder published
+#define FEEDER_DECODER_POLL_MS 10
+
+// Playback feeder thread: keep the ring full of the loop region, read from
+// the decoded buffer as the decoder or the PCM cache fills it. Where to
+// read comes from the callback through state->feed.
+static int playback_feeder_thread(void *data) {
+    AudioState *state = (AudioState *)data;
+    PcmBuffer *pcm = NULL;
+    int generation = 0;
+    Sint64 position = 0;
+
+    while (!SDL_GetAtomicInt(&state->feeder_quit)) {
+        // Copy the request, retrying if the callback was writing it meanwhile
+        PlaybackFeed *feed = &state->feed;
+        Sint64 frame, loop_start, loop_end;
+        int requested, sequence;
+        do {
+            sequence = SDL_GetAtomicInt(&feed->sequence);
+            requested = SDL_GetAtomicInt(&feed->generation);
+            frame = atomic_s64_get(&feed->frame);
+            loop_start = atomic_s64_get(&feed->loop_start);
+            loop_end = atomic_s64_get(&feed->loop_end);
+        } while ((sequence & 1) || sequence != SDL_GetAtomicInt(&feed->sequence));
+
+        if (requested != generation) {
+            generation = requested;
+            position = frame;
+        }
+        PlaybackBlock *block = playback_ring_back(&state->ring);
+        if (!block || generation == 0 || loop_end <= loop_start) {
+            SDL_WaitSemaphore(state->feeder_wake);
+            continue;
         }
 
-        if (bytes_to_copy_this_iteration > 0) {
-            memcpy(temp_buffer + bytes_provided, &state->playback_buffer[current_pos_samples], bytes_to_copy_this_iteration);
-            bytes_provided += bytes_to_copy_this_iteration;
-            current_pos_samples += bytes_to_copy_this_iteration / sizeof(float);
-        } else {
-            current_pos_samples = state->selection_start;
+        position = wrap_to_loop(position, loop_start, loop_end);
+        if (position >= pcm_buffer_frames(pcm)) {
+            // The decoder may have moved into a bigger buffer. After a stop
+            // request the state has none, and the old one plays on.
+            PcmBuffer *latest = audio_state_acquire_pcm(state);
+            if (latest) {
+                pcm_buffer_release(pcm);
+                pcm = latest;
+            }
+            if (position >= pcm_buffer_frames(pcm)) {
+                SDL_SetAtomicInt(&state->starved_generation, generation);
+                SDL_WaitSemaphoreTimeout(state->feeder_wake, FEEDER_DECODER_POLL_MS);
+                continue;
+            }
         }
+
+        // Flag reaching the decoder before the block goes out, so a callback
+        // that drains the ring finds the flag already set
+        const Sint64 available = pcm_buffer_frames(pcm);
+        const Sint64 frames = SDL_min(SDL_min(loop_end, available) - position,
+                                      PLAYBACK_RING_BLOCK_FRAMES);
+        const bool caught_up = position + frames >= available && available < loop_end;
+        SDL_SetAtomicInt(&state->starved_generation, caught_up ? generation : 0);
+        SDL_memcpy(block->samples, &pcm->samples[position * pcm->channels],
+                   (size_t)frames * pcm->channels * sizeof(float));
+        block->frame = position;
+        block->frames = (int)frames;
+        block->generation = generation;
+        playback_ring_push(&state->ring);
+        position += frames;
     }
 
-    SDL_PutAudioStreamData(stream, temp_buffer, total_bytes_needed);
-    SDL_SetAtomicInt(&state->playback_position, current_pos_samples);
-    SDL_free(temp_buffer);
+    pcm_buffer_release(pcm);
+    return 0;
 }
 
-// Process audio file using CARA beat tracking
-static void process_audio_file(AudioState *state) {
-  // Clean up previous processing if any - protected by mutex
-  SDL_LockMutex(state->data_mutex);
-  if (state->sample) {
-    Sound_FreeSample(state->sample);
-    state->sample = NULL;
+// Start the feeder for a device about to be opened. Nothing is read until
+// the callback's first request.
+static bool start_playback_feeder(AudioState *state, int channels) {
+  SDL_zero(state->feed);
+  SDL_SetAtomicInt(&state->feeder_quit, 0);
+  SDL_SetAtomicInt(&state->starved_generation, 0);
+  state->engine_feed_generation = 0;
+  state->engine_feed_next = 0;
+  state->engine_feed_started = false;
+
+  if (!playback_ring_init(&state->ring, channels)) {
+    return false;
   }
-  if (state->beat_positions) {
-    SDL_free(state->beat_positions);
-    state->beat_positions = NULL;
+  state->feeder_wake = SDL_CreateSemaphore(0);
+  if (state->feeder_wake) {
+    state->feeder = SDL_CreateThread(playback_feeder_thread, "PlaybackFeeder", state);
   }
-  state->beats_buffer_size = 1024;
-  state->beat_positions =
-      SDL_malloc(sizeof(unsigned int) * state->beats_buffer_size);
-  state->beat_count = 0;
-  state->status = STATUS_DECODE;
-  SDL_UnlockMutex(state->data_mutex);
+  if (!state->feeder) {
+    SDL_DestroySemaphore(state->feeder_wake);
+    state->feeder_wake = NULL;
+    playback_ring_free(&state->ring);
+    return false;
+  }
+  return true;
+}
 
-  // Initial file setup
-  state->sample =
-      Sound_NewSampleFromFile(state->file_path, &desired, 1048576);
-  if (!state->sample) {
-    printf("Error: Could not open audio file: %s\n", state->file_path);
-    return;
+// Join the feeder. Only once the device is closed, as the callback uses
+// the ring and the semaphore.
+static void stop_playback_feeder(AudioState *state) {
+  if (state->feeder) {
+    SDL_SetAtomicInt(&state->feeder_quit, 1);
+    SDL_SignalSemaphore(state->feeder_wake);
+    SDL_WaitThread(state->feeder, NULL);
+    state->feeder = NULL;
   }
+  SDL_DestroySemaphore(state->feeder_wake);
+  state->feeder_wake = NULL;
+  playback_ring_free(&state->ring);
+}
 
-  // File decoding
-  Uint32 decoded_bytes = Sound_DecodeAll(state->sample);
-  if (decoded_bytes == 0) {
-    printf("Error: Could not decode audio file: %s\n",
-           state->file_path);
-    Sound_FreeSample(state->sample);
-    state->sample = NULL;
+// Point playback at `pcm` and open the output device and stream. Only the
+// UI thread opens and closes them.
+static void open_playback_stream(AudioState *state, PcmBuffer *pcm) {
+  // Scrubbing reads the decoded buffer in place; linear playback reads it
+  // through the feeder's ring. Without a stream there is no callback, so a
+  // buffer left from an earlier failed open can go directly.
+  pcm_buffer_release(state->playback_pcm);
+  state->playback_pcm = pcm_buffer_retain(pcm);
+
+  scrub_engine_free(&state->scrub);
+  if (!scrub_engine_init(&state->scrub, pcm->channels, pcm->sample_rate)) {
+    printf("Warning: Could not allocate scrub buffers, scrubbing disabled\n");
+  }
+  if (!start_playback_feeder(state, pcm->channels)) {
+    printf("Error: Could not start playback feeder: %s\n", SDL_GetError());
     return;
   }
 
-  // Check for stop request after decoding
-  if (SDL_GetAtomicInt(&state->request_stop)) {
-    return;
+  SDL_AudioSpec spec = {.format = SDL_AUDIO_F32,
+                        .channels = pcm->channels,
+                        .freq = pcm->sample_rate};
+
+  state->audio_device =
+      SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec);
+  if (state->audio_device) {
+    SDL_AudioSpec device_spec;
+    int device_frames = 0;
+    state->device_latency_ns = 0;
+    if (SDL_GetAudioDeviceFormat(state->audio_device, &device_spec, &device_frames) &&
+        device_spec.freq > 0) {
+      state->device_latency_ns =
+          (Sint64)device_frames * (Sint64)SDL_NS_PER_SECOND / device_spec.freq;
+    }
+
+    state->audio_stream = SDL_CreateAudioStream(&spec, &spec);
+    if (state->audio_stream) {
+      SDL_SetAudioStreamGetCallback(state->audio_stream, audio_callback,
+                                    state);
+      SDL_BindAudioStream(state->audio_device, state->audio_stream);
+      SDL_PauseAudioDevice(state->audio_device); // Start paused
+    } else {
+      SDL_CloseAudioDevice(state->audio_device);
+      state->audio_device = 0;
+    }
+  }
+  if (!state->audio_stream) {
+    stop_playback_feeder(state);
   }
+}
 
-  SDL_LockMutex(state->data_mutex);
-  state->status = STATUS_BEAT_ANALYSIS;
-  SDL_UnlockMutex(state->data_mutex);
+// Hash of every setting that affects the analysis result. Cached analyses
+// made with different settings miss. The beat parameters are always CARA's
+// defaults, so the CARA revision stands in for them; hashing beat_params_t
+// itself would also take in whatever its padding holds.
+static Uint64 analysis_params_hash(void) {
+  const Uint64 settings[] = {ANALYSIS_FORMAT_VERSION, BEAT_WINDOW_SIZE,
+                             BEAT_HOP_LENGTH, BEAT_N_MELS, ANALYSIS_TARGET_RATE};
+  Uint64 hash = fnv1a(FNV1A_OFFSET, settings, sizeof(settings));
+  return fnv1a(hash, CARA_REVISION, sizeof(CARA_REVISION) - 1);
+}
 
-  // Convert SDL_Sound data to CARA format
-  audio_data *cara_audio = sdl_sound_to_cara_audio(state->sample);
-  if (!cara_audio) {
-    printf("Error: Could not convert audio data for CARA processing\n");
-    Sound_FreeSample(state->sample);
-    state->sample = NULL;
-    return;
+// Wait for any other job's beat tracking to finish. Returns false, without
+// holding analysis_mutex, if the job is cancelled first.
+static bool acquire_analysis(ProcessingJob *job) {
+  SDL_Mutex *mutex = job->state->analysis_mutex;
+  while (!SDL_TryLockMutex(mutex)) {
+    if (job_cancelled(job)) {
+      return false;
+    }
+    SDL_Delay(ANALYSIS_WAIT_POLL_MS);
   }
-  
+  if (job_cancelled(job)) {
+    SDL_UnlockMutex(mutex);
+    return false;
+  }
+  return true;
+}
 
-  // Set default selection to the entire track
-  state->selection_start = 0;
-  state->selection_end = state->sample->buffer_size / sizeof(float);
+// Run beat tracking on the job's PCM. Returns NULL on failure or
+// cancellation.
+static AnalysisData* run_beat_analysis(ProcessingJob *job, beat_params_t *params) {
+  // A job cancelled while an earlier one was still analysing leaves without
+  // starting CARA at all
+  begin_stage(job, STATUS_BEAT_ANALYSIS, PROGRESS_DECODE_END, PROGRESS_SIGNAL_END);
+  if (!acquire_analysis(job)) {
+    return NULL;
+  }
 
-  // CARA beat tracking parameters
-  const size_t window_size = 2048;
-  const size_t hop_length = 512;
-  const size_t n_mels = 128;
-  
-  beat_params_t params = get_default_beat_params();
-  
-  // Perform beat tracking using CARA
+  // CARA gets a mono signal at roughly ANALYSIS_TARGET_RATE. Playback and
+  // the waveform keep using the native-rate buffer. The decoder is done, so
+  // job->pcm won't be swapped while we read from it.
+  audio_data cara_audio;
+  bool owns_analysis_signal = false;
+  const int decimation = make_analysis_signal(job, &cara_audio, &owns_analysis_signal);
+  if (decimation == 0 || job_cancelled(job)) {
+    SDL_UnlockMutex(job->state->analysis_mutex);
+    if (decimation == 0 && !job_cancelled(job)) {
+      printf("Error: Could not allocate analysis signal\n");
+    }
+    if (decimation != 0 && owns_analysis_signal) {
+      SDL_free(cara_audio.samples);
+    }
+    return NULL;
+  }
+
+  // Perform beat tracking using CARA. It reports no progress and has no way
+  // to be interrupted, so a job cancelled meanwhile only notices once it
+  // returns. Its STFT and mel projection run inside this call, on this
+  // thread.
+  begin_opaque_stage(job, STATUS_BEAT_ANALYSIS, PROGRESS_SIGNAL_END, 1.0f);
   beat_result_t beat_result = beat_track_audio(
-    cara_audio, 
-    window_size, 
-    hop_length, 
-    n_mels,
-    &params, 
+    &cara_audio,
+    BEAT_WINDOW_SIZE,
+    BEAT_HOP_LENGTH,
+    BEAT_N_MELS,
+    params,
     BEAT_UNITS_SAMPLES  // Get results in sample positions
   );
+  SDL_UnlockMutex(job->state->analysis_mutex);
 
-  // Check for stop request after beat tracking
-  if (SDL_GetAtomicInt(&state->request_stop)) {
+  AnalysisData *analysis = job_cancelled(job) ? NULL : SDL_calloc(1, sizeof(AnalysisData));
+  if (analysis) {
+    analysis->tempo_bpm = beat_result.tempo_bpm;
+  }
+
+  if (owns_analysis_signal) {
+    SDL_free(cara_audio.samples);
+  }
+
+  if (!analysis || job_cancelled(job)) {
     free_beat_result(&beat_result);
-    free_cara_audio(cara_audio);
-    return;
+    analysis_data_free(analysis);
+    return NULL;
   }
 
-  // Convert CARA results to our format
-  SDL_LockMutex(state->data_mutex);
   if (beat_result.num_beats > 0 && beat_result.beat_times) {
-    // Ensure we have enough space
-    if (beat_result.num_beats > (size_t)state->beats_buffer_size) {
-      size_t new_buffer_size = beat_result.num_beats * 2;
-      unsigned int *new_beat_positions = SDL_realloc(state->beat_positions,
-                                     sizeof(unsigned int) * new_buffer_size);
-      if (!new_beat_positions) {
-        printf("Error: Could not reallocate beat positions buffer\n");
-        SDL_UnlockMutex(state->data_mutex);
-        free_beat_result(&beat_result);
-        free_cara_audio(cara_audio);
-        return;
-      }
-      state->beat_positions = new_beat_positions;
-      state->beats_buffer_size = new_buffer_size;
+    analysis->beats = SDL_malloc(sizeof(Sint64) * beat_result.num_beats);
+    if (!analysis->beats) {
+      printf("Error: Could not allocate beat positions buffer\n");
+      free_beat_result(&beat_result);
+      analysis_data_free(analysis);
+      return NULL;
     }
+    analysis->beat_count = (Sint64)beat_result.num_beats;
 
-    // Copy beat positions - CARA returns sample positions when using BEAT_UNITS_SAMPLES
-    state->beat_count = beat_result.num_beats;
+    // Copy beat positions - CARA returns frame positions of the analysis
+    // signal when using BEAT_UNITS_SAMPLES, so scale them back up to the
+    // native rate
     for (size_t i = 0; i < beat_result.num_beats; i++) {
-      // CARA returns sample positions in terms of frames, but we need to convert to 
-      // interleaved sample positions for stereo audio
-      unsigned int frame_position = (unsigned int)beat_result.beat_times[i];
+      Sint64 frame_position = (Sint64)beat_result.beat_times[i];
 
       // Apply offset to account for STFT centering behavior
       // CARA currently implements center=False behavior, but we need center=True alignment
       // Add half the window size to center the frame positions correctly
-      const int center_offset = window_size / 2;
+      const Sint64 center_offset = BEAT_WINDOW_SIZE / 2;
       frame_position += center_offset;
 
-      // For stereo audio, multiply by channel count to get the correct sample position
-      state->beat_positions[i] = frame_position * state->sample->actual.channels;
+      analysis->beats[i] = frame_position * decimation;
     }
-    
-    printf("CARA beat tracking completed: %d beats found, tempo: %.2f BPM\n", 
-           state->beat_count, beat_result.tempo_bpm);
-    printf("Total audio samples: %d\n", (int)(state->sample->buffer_size / sizeof(float)));
-    printf("Audio duration: %.2f seconds\n", (float)(state->sample->buffer_size / sizeof(float)) / state->sample->actual.rate);
+  }
+
+  report_progress(job, 1.0);
+  free_beat_result(&beat_result);
+  return analysis;
+}
+
+// Hand a finished analysis to the UI. Its beats are complete and never
+// change, so the state uses them in place, straight from the sidecar
+// mapping when it was cached. The state takes ownership of `analysis`; if
+// the job has been cancelled it is freed instead and false is returned.
+static bool publish_analysis(ProcessingJob *job, AnalysisData *analysis) {
+  if (!lock_for_job(job)) {
+    analysis_data_free(analysis);
+    return false;
+  }
+  AudioState *state = job->state;
+  state->analysis = analysis;
+  if (analysis->beat_count > 0) {
+    state->beat_positions = analysis->beats;
+    state->beat_count = (int)analysis->beat_count;
+
+    printf("Beat analysis: %d beats, tempo: %.2f BPM\n",
+           state->beat_count, analysis->tempo_bpm);
     printf("First few beat positions: ");
     for (int i = 0; i < (state->beat_count < 5 ? state->beat_count : 5); i++) {
-      printf("%u ", state->beat_positions[i]);
+      printf("%" SDL_PRIs64 " ", state->beat_positions[i]);
     }
     printf("\n");
     printf("Last few beat positions: ");
     int start_idx = state->beat_count > 5 ? state->beat_count - 5 : 0;
     for (int i = start_idx; i < state->beat_count; i++) {
-      printf("%u ", state->beat_positions[i]);
-    }
-    printf("\n");
-    printf("Beat positions as time (seconds): ");
-    for (int i = 0; i < (state->beat_count < 5 ? state->beat_count : 5); i++) {
-      printf("%.2f ", (float)state->beat_positions[i] / state->sample->actual.rate);
+      printf("%" SDL_PRIs64 " ", state->beat_positions[i]);
     }
     printf("\n");
   } else {
-    printf("CARA beat tracking found no beats\n");
+    printf("Beat analysis found no beats\n");
     state->beat_count = 0;
   }
+  SDL_UnlockMutex(state->data_mutex);
+  return true;
+}
 
-  state->status = STATUS_COMPLETED;
+// Process audio file using CARA beat tracking
+static void process_audio_file(ProcessingJob *job) {
+  beat_params_t params = get_default_beat_params();
+  const Uint64 params_hash = analysis_params_hash();
 
-  // Create playback buffer
-  if (!state->playback_buffer) {
-    state->playback_buffer_size = state->sample->buffer_size / sizeof(float);
-    state->playback_buffer = SDL_malloc(state->sample->buffer_size);
-    if (state->playback_buffer) {
-      memcpy(state->playback_buffer, state->sample->buffer,
-             state->sample->buffer_size);
-    }
+  // Files opened before come back from the caches: the analysis sidecar is
+  // mapped and published straight away, with the waveform peaks it holds,
+  // and the PCM is streamed back without decoding
+  PcmCacheKey cache_key;
+  const bool cacheable = pcm_cache_make_key(job->file_path, &cache_key);
+  AnalysisData *cached_analysis =
+      cacheable ? analysis_cache_load(&cache_key, params_hash) : NULL;
+
+  // With nothing left to analyse, decoding fills the whole progress bar
+  begin_stage(job, STATUS_DECODE, 0.0f, cached_analysis ? 1.0f : PROGRESS_DECODE_END);
+
+  // The peaks are copied out of the sidecar before it is published: from
+  // then on the UI thread may unmap it
+  PcmCacheReader *cached_pcm =
+      cacheable ? open_cached_pcm(job, &cache_key, cached_analysis) : NULL;
+  if (cached_analysis && !publish_analysis(job, cached_analysis)) {
+    pcm_cache_close(cached_pcm);
+    return;
   }
+  const bool from_cache = cached_pcm && stream_cached_pcm(job, cached_pcm);
 
-  // Set up audio stream
-  if (!state->audio_stream) {
-    SDL_AudioSpec spec = {.format = SDL_AUDIO_F32,
-                          .channels = state->sample->actual.channels,
-                          .freq = state->sample->actual.rate};
+  if (!from_cache) {
+    if (job_cancelled(job)) {
+      return;
+    }
+    Sound_Sample *sample = job->sample ? job->sample : audio_state_open_sample(job->file_path);
+    job->sample = NULL;
+    if (!sample) {
+      return;
+    }
 
-    state->audio_device =
-        SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec);
-    if (state->audio_device) {
-      state->audio_stream = SDL_CreateAudioStream(&spec, &spec);
-      if (state->audio_stream) {
-        SDL_SetAudioStreamGetCallback(state->audio_stream, audio_callback,
-                                      state);
-        SDL_BindAudioStream(state->audio_device, state->audio_stream);
-        SDL_PauseAudioDevice(state->audio_device); // Start paused
-      } else {
-        SDL_CloseAudioDevice(state->audio_device);
-        state->audio_device = 0;
+    // File decoding, published progressively for the waveform display
+    bool decoded = decode_audio_file(job, sample);
+    Sound_FreeSample(sample);
+    if (!decoded) {
+      if (!job_cancelled(job)) {
+        printf("Error: Could not decode audio file: %s\n", job->file_path);
       }
+      return;
+    }
+  }
+
+  // Publish the exact length; the UI thread takes it from there (see
+  // sync_timeline)
+  const Sint64 total_frames = pcm_buffer_frames(job->pcm);
+  if (!lock_for_job(job)) {
+    return;
+  }
+  job->state->loaded_frames = total_frames;
+  SDL_UnlockMutex(job->state->data_mutex);
+  printf("Total audio frames: %" SDL_PRIs64 " (%.2f seconds)\n", total_frames,
+         (double)total_frames / (double)job->pcm->sample_rate);
+
+  if (!cached_analysis) {
+    AnalysisData *analysis = run_beat_analysis(job, &params);
+    if (!analysis) {
+      return;
+    }
+
+    // Once published the analysis belongs to the state and the UI thread
+    // may free it, so the sidecar is written first
+    if (cacheable && !analysis_cache_store(&cache_key, params_hash, analysis,
+                                           &job->pcm->peaks)) {
+      printf("Warning: Could not write the analysis sidecar\n");
+    }
+    if (!publish_analysis(job, analysis)) {
+      return;
     }
   }
 
+  if (!lock_for_job(job)) {
+    return;
+  }
+  AudioState *state = job->state;
+  state->status = STATUS_COMPLETED;
   SDL_UnlockMutex(state->data_mutex);
 
-  // Cleanup CARA resources
-  free_beat_result(&beat_result);
-  free_cara_audio(cara_audio);
+  // Keep the decoded audio for the next time this file is opened. The job
+  // holds its own reference, so this is safe even if it gets cancelled.
+  // Batch runs leave the cache to files opened interactively.
+  if (cacheable && !from_cache && !state->headless &&
+      !pcm_cache_store(&cache_key, job->pcm, &job->cancel) &&
+      !job_cancelled(job)) {
+    printf("Warning: Could not write decoded audio to the cache\n");
+  }
 }
 
-// Processing thread (moved from main.c, made static)
-static int audio_processing_thread(void *data) {
-    AudioState *state = (AudioState *)data;
-    
-    process_audio_file(state);
-    
+static void release_state(AudioState *state);
+
+// Run a job to completion or cancellation, then free it
+static void run_job(ProcessingJob *job) {
+    AudioState *state = job->state;
+
+    process_audio_file(job);
+
     SDL_LockMutex(state->data_mutex);
-    if (state->status != STATUS_COMPLETED) {
-        state->status = STATUS_IDLE;
+    if (state->job == job) {
+        if (state->status != STATUS_COMPLETED) {
+            state->status = STATUS_IDLE;
+        }
+        state->job = NULL;
     }
     SDL_UnlockMutex(state->data_mutex);
-    
+
+    if (job->sample) {
+        Sound_FreeSample(job->sample);
+    }
+    pcm_buffer_release(job->pcm);
+    SDL_free(job->file_path);
+    SDL_free(job);
+
+    SDL_AddAtomicInt(&state->live_jobs, -1);
+    release_state(state);
+}
+
+// Processing thread (moved from main.c, made static). Owns its job.
+static int audio_processing_thread(void *data) {
+    run_job((ProcessingJob *)data);
     return 0;
 }
 
+// Cancel the load in progress, if any, without waiting for its thread.
+// Must be called with data_mutex held.
+static void cancel_job_locked(AudioState *state) {
+    if (state->job) {
+        SDL_SetAtomicInt(&state->job->cancel, 1);
+        state->job = NULL;
+    }
+    state->status = STATUS_IDLE;
+}
+
 // Create new audio state
 AudioState* audio_state_create(void) {
     AudioState *state = SDL_calloc(1, sizeof(AudioState));
     if (!state) return NULL;
     
+    // Pick the SIMD conversion kernels before the decoder first needs them
+    convert_init();
+
     state->data_mutex = SDL_CreateMutex();
-    if (!state->data_mutex) {
+    state->analysis_mutex = SDL_CreateMutex();
+    if (!state->data_mutex || !state->analysis_mutex) {
+        SDL_DestroyMutex(state->data_mutex);
+        SDL_DestroyMutex(state->analysis_mutex);
         SDL_free(state);
         return NULL;
     }
     
-    SDL_SetAtomicInt(&state->request_stop, 0);
-    SDL_SetAtomicInt(&state->playback_position, 0);
+    SDL_SetAtomicInt(&state->live_jobs, 0);
+    SDL_SetAtomicInt(&state->refs, 1);
+    atomic_s64_set(&state->playback_position, 0);
     state->status = STATUS_IDLE;
     state->playback_state = PLAYBACK_STOPPED;
     state->follow_playback = false;
@@ -339,15 +1203,22 @@ AudioState* audio_state_create(void) {
     // Initialize audio streaming components
     state->audio_stream = NULL;
     state->audio_device = 0;
-    state->playback_buffer = NULL;
-    state->playback_buffer_size = 0;
+    state->playback_pcm = NULL;
+    state->offered_pcm = NULL;
+    state->incoming_pcm = NULL;
+    state->retired_pcm = NULL;
     
     return state;
 }
 
-// Load and process audio file
-void audio_state_load_file(AudioState *state, const char *file_path) {
-    if (!state || !file_path) return;
+// Drop the current file, cancelling its load if one is in progress, and
+// make a new job for `file_path` the state's current one
+static ProcessingJob* begin_job(AudioState *state, const char *file_path) {
+    // From here on the previous job can't touch the state, so its results
+    // can be dropped while its thread winds down in the background
+    SDL_LockMutex(state->data_mutex);
+    cancel_job_locked(state);
+    SDL_UnlockMutex(state->data_mutex);
 
     // Stop playback and clean up any existing audio stream/device
     audio_state_stop_playback(state);
@@ -365,92 +1236,170 @@ void audio_state_load_file(AudioState *state, const char *file_path) {
         SDL_DestroyAudioStream(state->audio_stream);
         state->audio_stream = NULL;
     }
-    
-    // Wait for any existing processing to finish before loading a new file
-    if (state->processing_thread) {
-        SDL_SetAtomicInt(&state->request_stop, 1);
-        SDL_WaitThread(state->processing_thread, NULL);
-        state->processing_thread = NULL;
-        SDL_SetAtomicInt(&state->request_stop, 0); // Reset for next operation
-    }
+    stop_playback_feeder(state);
+
+    // With the device closed nothing consumes commands; start the next
+    // stream with an empty queue and no seek in flight
+    playback_queue_reset(&state->commands);
+    state->loop_dirty = true;
+    state->seek_dirty = false;
+    SDL_SetAtomicInt(&state->applied_seek_serial, (int)state->seek_serial);
+    state->engine_seek_serial = state->seek_serial;
+    state->engine_state = PLAYBACK_STOPPED;
+    state->scrubbing = false;
+    state->scrub_pausing = false;
+    state->engine_scrub_serial = state->scrub_serial;
+    SDL_SetAtomicInt(&state->finished_scrub_serial, (int)state->scrub_serial);
 
     // Clean up all data related to the previous file
     if (state->file_path) {
         SDL_free(state->file_path);
         state->file_path = NULL;
     }
-    if (state->sample) {
-        Sound_FreeSample(state->sample);
-        state->sample = NULL;
-    }
-    if (state->beat_positions) {
-        SDL_free(state->beat_positions);
-        state->beat_positions = NULL;
-        state->beat_count = 0;
-    }
-    if (state->playback_buffer) {
-        SDL_free(state->playback_buffer);
-        state->playback_buffer = NULL;
-        state->playback_buffer_size = 0;
-    }
+    state->beat_positions = NULL;
+    state->beat_count = 0;
+    analysis_data_free(state->analysis);
+    state->analysis = NULL;
+    release_pcm(state);
+    state->load_generation++;
     
     // Now, create a persistent copy of the new file path
     state->file_path = SDL_strdup(file_path);
-    if (!state->file_path) {
+    ProcessingJob *job = SDL_calloc(1, sizeof(ProcessingJob));
+    if (!state->file_path || !job || !(job->file_path = SDL_strdup(file_path))) {
         printf("Error: Could not allocate memory for file path.\n");
-        return;
+        SDL_free(job);
+        return NULL;
     }
-    
-    // Start the processing thread for the new file
-    state->processing_thread = SDL_CreateThread(
-        audio_processing_thread, "AudioProcessing", state);
-    
-    if (!state->processing_thread) {
+    job->state = state;
+    SDL_SetAtomicInt(&job->cancel, 0);
+
+    SDL_LockMutex(state->data_mutex);
+    state->job = job;
+    state->status = STATUS_DECODE;
+    state->processing_progress = 0.0f;
+    state->progress_indeterminate = false;
+    SDL_UnlockMutex(state->data_mutex);
+    SDL_AddAtomicInt(&state->live_jobs, 1);
+    SDL_AddAtomicInt(&state->refs, 1);
+
+    return job;
+}
+
+// Load and process audio file. Returns immediately: a load still in
+// progress is cancelled, not waited for.
+void audio_state_load_file(AudioState *state, const char *file_path) {
+    if (!state || !file_path) return;
+
+    ProcessingJob *job = begin_job(state, file_path);
+    if (!job) return;
+
+    // Start the processing thread for the new file. Nobody joins it; it
+    // frees its job when done.
+    SDL_Thread *thread = SDL_CreateThread(
+        audio_processing_thread, "AudioProcessing", job);
+    if (!thread) {
         printf("Error: Could not create audio processing thread: %s\n",
                SDL_GetError());
+        SDL_AddAtomicInt(&state->live_jobs, -1);
+        SDL_AddAtomicInt(&state->refs, -1);
+        SDL_LockMutex(state->data_mutex);
+        cancel_job_locked(state);
+        SDL_UnlockMutex(state->data_mutex);
+        SDL_free(job->file_path);
+        SDL_free(job);
+        return;
     }
+    SDL_DetachThread(thread);
 }
 
-// Request to stop ongoing processing gracefully
-void audio_state_request_stop(AudioState *state) {
-    if (!state) return;
-    
-    // Set the stop flag
-    SDL_SetAtomicInt(&state->request_stop, 1);
-    
-    // Wait for the processing thread to finish
-    if (state->processing_thread) {
-        SDL_WaitThread(state->processing_thread, NULL);
-        state->processing_thread = NULL;
+Sint64 audio_state_estimate_bytes(Sint64 frames, int channels, int sample_rate) {
+    if (frames <= 0) return 0;
+
+    const int factor = sample_rate > ANALYSIS_TARGET_RATE ? sample_rate / ANALYSIS_TARGET_RATE : 1;
+    const Sint64 analysis_samples = frames / factor;
+    const Sint64 hops = analysis_samples / BEAT_HOP_LENGTH + 1;
+
+    // The pyramid's levels together hold about twice the finest one. CARA's
+    // internals aren't ours to measure, so assume a complex STFT and a mel
+    // spectrogram both alive at once.
+    const Sint64 pcm = frames * channels * (Sint64)sizeof(float);
+    const Sint64 pyramid = 2 * (frames / WAVEFORM_PEAK_BLOCK + 1) * (Sint64)sizeof(WaveformPeak);
+    const Sint64 spectrograms =
+        hops * ((BEAT_WINDOW_SIZE / 2 + 1) * 2 + BEAT_N_MELS) * (Sint64)sizeof(float);
+    return pcm + analysis_samples * (Sint64)sizeof(float) + pyramid + spectrograms;
+}
+
+static void sync_timeline(AudioState *state);
+
+// Decode and analyse a file on the calling thread
+bool audio_state_process_file(AudioState *state, const char *file_path) {
+    return audio_state_process_sample(state, file_path, NULL);
+}
+
+// Same, decoding from a sample the caller already opened
+bool audio_state_process_sample(AudioState *state, const char *file_path,
+                                Sound_Sample *sample) {
+    ProcessingJob *job = state && file_path ? begin_job(state, file_path) : NULL;
+    if (!job) {
+        if (sample) {
+            Sound_FreeSample(sample);
+        }
+        return false;
     }
-    
-    // Reset the stop flag for future operations
-    SDL_SetAtomicInt(&state->request_stop, 0);
-    
-    // Clean up resources
+    job->sample = sample;
+    run_job(job);
+    sync_timeline(state);
+
     SDL_LockMutex(state->data_mutex);
-    if (state->sample) {
-        Sound_FreeSample(state->sample);
-        state->sample = NULL;
-    }
-    if (state->beat_positions) {
-        SDL_free(state->beat_positions);
-        state->beat_positions = NULL;
-        state->beat_count = 0;
-        state->beats_buffer_size = 0;
-    }
-    state->status = STATUS_IDLE;
+    bool completed = state->status == STATUS_COMPLETED;
     SDL_UnlockMutex(state->data_mutex);
+    return completed;
 }
 
-// Clean up processing resources
-void audio_state_cleanup_processing(AudioState *state) {
+// Cancel ongoing processing and drop what it produced. Doesn't wait for
+// the processing thread.
+void audio_state_request_stop(AudioState *state) {
     if (!state) return;
     
-    if (state->processing_thread) {
-        SDL_WaitThread(state->processing_thread, NULL);
-        state->processing_thread = NULL;
+    SDL_LockMutex(state->data_mutex);
+    cancel_job_locked(state);
+    state->beat_positions = NULL;
+    state->beat_count = 0;
+    analysis_data_free(state->analysis);
+    state->analysis = NULL;
+
+    // Only our reference is dropped: if a track is already playing, the
+    // audio callback keeps reading through its own until the next load
+    pcm_buffer_release(state->pcm);
+    state->pcm = NULL;
+    state->loaded_frames = 0;
+    SDL_UnlockMutex(state->data_mutex);
+    state->total_frames = 0;
+    state->selection_start = 0;
+    state->selection_end = 0;
+    state->selection_user_set = false;
+}
+
+// Cancel ongoing processing and wait for every processing thread, including
+// ones cancelled earlier, to exit
+bool audio_state_cleanup_processing(AudioState *state, Uint32 timeout_ms) {
+    if (!state) return true;
+
+    SDL_LockMutex(state->data_mutex);
+    cancel_job_locked(state);
+    SDL_UnlockMutex(state->data_mutex);
+
+    // Cancelled jobs exit within one decode chunk, unless they are inside
+    // beat_track_audio
+    const Uint64 deadline = SDL_GetTicks() + timeout_ms;
+    while (SDL_GetAtomicInt(&state->live_jobs) > 0) {
+        if (SDL_GetTicks() >= deadline) {
+            return false;
+        }
+        SDL_Delay(5);
     }
+    return true;
 }
 
 // Destroy audio state
@@ -475,52 +1424,174 @@ void audio_state_destroy(AudioState *state) {
         SDL_DestroyAudioStream(state->audio_stream);
         state->audio_stream = NULL;
     }
+    stop_playback_feeder(state);
     
-    // Ensure processing thread is finished
-    if (state->processing_thread) {
-        SDL_SetAtomicInt(&state->request_stop, 1);
-        SDL_WaitThread(state->processing_thread, NULL);
-        state->processing_thread = NULL;
+    // A job still inside beat_track_audio at exit touches the state once it
+    // returns, so in that case the last job out frees it instead
+    if (!audio_state_cleanup_processing(state, JOB_SHUTDOWN_TIMEOUT_MS)) {
+        printf("Warning: Audio processing still running at exit\n");
     }
-    
-    // Destroy mutex
-    if (state->data_mutex) {
-        SDL_DestroyMutex(state->data_mutex);
+    release_state(state);
+}
+
+// Drop a reference to the state, freeing it with the last one. The owner
+// holds one until audio_state_destroy and every job holds one while it runs.
+static void release_state(AudioState *state) {
+    if (SDL_AddAtomicInt(&state->refs, -1) != 1) {
+        return;
     }
+
+    release_pcm(state);
+    
+    // Destroy mutexes
+    SDL_DestroyMutex(state->data_mutex);
+    SDL_DestroyMutex(state->analysis_mutex);
     
     // Free all dynamically allocated memory
     if (state->file_path) {
         SDL_free(state->file_path);
     }
-    if (state->sample) {
-        Sound_FreeSample(state->sample);
-    }
-    if (state->beat_positions) {
-        SDL_free(state->beat_positions);
-    }
-    if (state->playback_buffer) {
-        SDL_free(state->playback_buffer);
-    }
+    analysis_data_free(state->analysis);
     
     // Finally, free the state struct itself
     SDL_free(state);
 }
 
+// Push a command for the audio callback. Failing means the callback has
+// stopped draining the queue.
+static bool push_playback_command(AudioState *state, PlaybackCommandType type) {
+    const PlaybackCommand command = {.type = type, .serial = state->play_serial};
+    if (!playback_queue_push(&state->commands, &command)) {
+        printf("Warning: Playback command queue is full\n");
+        return false;
+    }
+    return true;
+}
+
+// Push the pending loop region and seek, if any
+static void flush_playback_changes(AudioState *state) {
+    // sync_timeline also moves the default selection as the length becomes
+    // known, so compare against what was sent rather than relying on the
+    // dirty flag alone
+    if (state->loop_dirty || state->selection_start != state->pushed_loop_start ||
+        state->selection_end != state->pushed_loop_end) {
+        const PlaybackCommand loop = {.type = PLAYBACK_CMD_SET_LOOP,
+                                      .frame = state->selection_start,
+                                      .end = state->selection_end};
+        if (playback_queue_push(&state->commands, &loop)) {
+            state->loop_dirty = false;
+            state->pushed_loop_start = loop.frame;
+            state->pushed_loop_end = loop.end;
+        }
+    }
+    if (state->seek_dirty) {
+        const PlaybackCommand seek = {.type = PLAYBACK_CMD_SEEK,
+                                      .frame = state->requested_position,
+                                      .serial = state->seek_serial};
+        state->seek_dirty = !playback_queue_push(&state->commands, &seek);
+        // Drop audio already queued from the old position. Clearing after
+        // the push means anything queued since comes from the new one.
+        if (!state->seek_dirty && state->audio_stream) {
+            SDL_ClearAudioStream(state->audio_stream);
+        }
+    }
+}
+
+static void request_seek(AudioState *state, Sint64 frame) {
+    state->seek_serial++;
+    state->requested_position = frame;
+    state->seek_dirty = true;
+}
+
+// Take over the length the loader has published: its estimate while
+// decoding, the exact one once done. The selection covers the whole file
+// until the user sets one, so it grows with the estimate but a selection
+// made during the load is kept.
+static void sync_timeline(AudioState *state) {
+    SDL_LockMutex(state->data_mutex);
+    const Sint64 frames = state->loaded_frames;
+    SDL_UnlockMutex(state->data_mutex);
+    if (frames == state->total_frames) return;
+
+    state->total_frames = frames;
+    if (!state->selection_user_set) {
+        state->selection_start = 0;
+        state->selection_end = frames;
+    }
+}
+
+// Keep playback on the buffer the loader is filling: open the device on
+// the first one, and offer the callback each bigger one the decoder moves
+// to. An earlier offer it hasn't picked up yet is stale and dropped.
+static void follow_decoder(AudioState *state) {
+    if (state->headless) return;
+
+    SDL_LockMutex(state->data_mutex);
+    PcmBuffer *pcm = state->pcm != state->offered_pcm ? pcm_buffer_retain(state->pcm) : NULL;
+    SDL_UnlockMutex(state->data_mutex);
+    if (!pcm) return;
+
+    if (!state->audio_stream) {
+        open_playback_stream(state, pcm);
+    } else {
+        pcm_buffer_release(SDL_SetAtomicPointer((void **)&state->incoming_pcm,
+                                                pcm_buffer_retain(pcm)));
+    }
+    pcm_buffer_release(state->offered_pcm);
+    state->offered_pcm = pcm;
+}
+
+void audio_state_sync_playback(AudioState *state) {
+    if (!state) return;
+    pcm_buffer_release(SDL_SetAtomicPointer((void **)&state->retired_pcm, NULL));
+    sync_timeline(state);
+    follow_decoder(state);
+
+    // A scrub over paused or stopped playback kept the device running;
+    // pause it once the last grains have faded out
+    if (state->scrub_pausing &&
+        (Uint32)SDL_GetAtomicInt(&state->finished_scrub_serial) == state->scrub_serial) {
+        state->scrub_pausing = false;
+        if (state->playback_state != PLAYBACK_PLAYING && state->audio_device) {
+            SDL_PauseAudioDevice(state->audio_device);
+        }
+    }
+
+    // A paused or stopped callback doesn't drain the queue, so changes
+    // wait here and go out with the next play
+    if (state->playback_state != PLAYBACK_PLAYING) return;
+    flush_playback_changes(state);
+}
+
+bool audio_state_can_play(AudioState *state) {
+    if (!state) return false;
+    SDL_LockMutex(state->data_mutex);
+    const bool ready = state->audio_stream && pcm_buffer_frames(state->pcm) > 0;
+    SDL_UnlockMutex(state->data_mutex);
+    return ready;
+}
+
 // Start audio playback
 bool audio_state_start_playback(AudioState *state) {
-    if (!state || !state->sample || state->playback_state == PLAYBACK_PLAYING) {
+    if (!state || state->playback_state == PLAYBACK_PLAYING || !audio_state_can_play(state)) {
         return false;
     }
 
     if (state->playback_state == PLAYBACK_STOPPED && audio_state_get_playback_position(state) == 0) {
-        SDL_SetAtomicInt(&state->playback_position, state->selection_start);
+        request_seek(state, state->selection_start);
     }
-    
-    if (!state->audio_stream) {
+
+    // Nothing was pushed since the device opened, so always send the loop
+    state->loop_dirty = true;
+    flush_playback_changes(state);
+    state->play_serial++;
+    if (!push_playback_command(state, PLAYBACK_CMD_PLAY)) {
         return false;
     }
+    state->held_position = audio_state_get_playback_position(state);
     
     state->playback_state = PLAYBACK_PLAYING;
+    state->scrub_pausing = false;
     SDL_ResumeAudioDevice(state->audio_device);
     
     printf("Audio playback started\n");
@@ -530,6 +1601,8 @@ bool audio_state_start_playback(AudioState *state) {
 // Stop audio playback
 void audio_state_stop_playback(AudioState *state) {
     if (!state) return;
+
+    push_playback_command(state, PLAYBACK_CMD_STOP);
     
     if (state->audio_device) {
         SDL_PauseAudioDevice(state->audio_device);
@@ -541,6 +1614,8 @@ void audio_state_stop_playback(AudioState *state) {
     }
     
     state->playback_state = PLAYBACK_STOPPED;
+    state->scrubbing = false;
+    state->scrub_pausing = false;
     
     printf("Audio playback stopped\n");
 }
@@ -548,8 +1623,13 @@ void audio_state_stop_playback(AudioState *state) {
 // Pause audio playback
 void audio_state_pause_playback(AudioState *state) {
     if (!state || state->playback_state != PLAYBACK_PLAYING) return;
+
+    // Hold the cursor where the sound stops; the queued audio resumes from there
+    state->held_position = audio_state_get_audible_position(state, SDL_GetTicksNS());
+    push_playback_command(state, PLAYBACK_CMD_PAUSE);
     
-    if (state->audio_device) {
+    // A scrub keeps the device running until it ends
+    if (state->audio_device && !state->scrubbing) {
         SDL_PauseAudioDevice(state->audio_device);
     }
     
@@ -560,34 +1640,194 @@ void audio_state_pause_playback(AudioState *state) {
 // Resume audio playback
 void audio_state_resume_playback(AudioState *state) {
     if (!state || state->playback_state != PLAYBACK_PAUSED) return;
+
+    flush_playback_changes(state);
+    state->play_serial++;
+    if (!push_playback_command(state, PLAYBACK_CMD_PLAY)) return;
     
     if (state->audio_device) {
         SDL_ResumeAudioDevice(state->audio_device);
     }
     
     state->playback_state = PLAYBACK_PLAYING;
+    state->scrub_pausing = false;
     printf("Audio playback resumed\n");
 }
 
-// Set playback position
-void audio_state_set_playback_position(AudioState *state, unsigned int position) {
+// Clamp to the timeline. playback_pcm belongs to the callback; the
+// (estimated) length will do.
+static Sint64 clamp_position(const AudioState *state, Sint64 frame) {
+    if (frame < 0) {
+        return 0;
+    }
+    if (frame > state->total_frames) {
+        return state->total_frames;
+    }
+    return frame;
+}
+
+// Set playback position. The seek reaches the callback with the next
+// audio_state_sync_playback(), so a burst of calls costs one seek.
+void audio_state_set_playback_position(AudioState *state, Sint64 frame) {
     if (!state) return;
-    
-    // Clamp position to valid range
-    if (position > state->playback_buffer_size) {
-        position = state->playback_buffer_size;
+    request_seek(state, clamp_position(state, frame));
+}
+
+bool audio_state_begin_scrub(AudioState *state, Sint64 frame) {
+    if (!state || state->scrubbing || !state->scrub.output || !audio_state_can_play(state)) {
+        return false;
     }
-    
-    SDL_SetAtomicInt(&state->playback_position, position);
 
-    // If we are playing, we need to clear the stream to seek correctly
-    if (state->audio_stream) {
+    frame = clamp_position(state, frame);
+    atomic_s64_set(&state->scrub_target, frame);
+    const PlaybackCommand begin = {.type = PLAYBACK_CMD_SCRUB_BEGIN,
+                                   .frame = frame,
+                                   .serial = state->scrub_serial + 1};
+    if (!playback_queue_push(&state->commands, &begin)) {
+        printf("Warning: Playback command queue is full\n");
+        return false;
+    }
+    state->scrub_serial++;
+    state->scrubbing = true;
+    state->scrub_position = frame;
+    state->scrub_pausing = false;
+
+    // Grains need the device running. Audio left queued by a pause would
+    // play first, so drop it; the scrub decides where playback goes next.
+    if (state->playback_state != PLAYBACK_PLAYING) {
         SDL_ClearAudioStream(state->audio_stream);
+        SDL_ResumeAudioDevice(state->audio_device);
+    }
+    return true;
+}
+
+void audio_state_scrub_to(AudioState *state, Sint64 frame) {
+    if (!state || !state->scrubbing) return;
+    state->scrub_position = clamp_position(state, frame);
+    atomic_s64_set(&state->scrub_target, state->scrub_position);
+}
+
+void audio_state_end_scrub(AudioState *state) {
+    if (!state || !state->scrubbing) return;
+    state->scrubbing = false;
+
+    // Ending is a seek to the last pointer position, so it supersedes any
+    // seek still waiting to be pushed
+    const Sint64 frame = state->scrub_position;
+    state->seek_serial++;
+    state->requested_position = frame;
+    state->seek_dirty = false;
+    state->held_position = frame;
+    const PlaybackCommand end = {.type = PLAYBACK_CMD_SCRUB_END,
+                                 .frame = frame,
+                                 .serial = state->seek_serial};
+    if (!playback_queue_push(&state->commands, &end)) {
+        printf("Warning: Playback command queue is full\n");
+    }
+
+    if (state->playback_state == PLAYBACK_PLAYING) {
+        // Playback continues from `frame`; hold the cursor there until the
+        // callback publishes a clock for it
+        state->play_serial++;
+        push_playback_command(state, PLAYBACK_CMD_PLAY);
+    } else {
+        state->scrub_pausing = true;
     }
 }
 
+void audio_state_set_selection(AudioState *state, Sint64 start, Sint64 end) {
+    if (!state) return;
+
+    state->selection_start = start;
+    state->selection_end = end;
+    state->selection_user_set = true;
+    state->loop_dirty = true;
+}
+
+// Borrow the decoded audio
+PcmBuffer* audio_state_acquire_pcm(AudioState *state) {
+    if (!state) return NULL;
+
+    SDL_LockMutex(state->data_mutex);
+    PcmBuffer *pcm = pcm_buffer_retain(state->pcm);
+    SDL_UnlockMutex(state->data_mutex);
+
+    return pcm;
+}
+
 // Get current playback position
-unsigned int audio_state_get_playback_position(AudioState *state) {
+Sint64 audio_state_get_playback_position(AudioState *state) {
+    if (!state) return 0;
+    if (state->scrubbing) {
+        return state->scrub_position;
+    }
+    // Until the callback has applied the latest seek, report its target
+    if ((Uint32)SDL_GetAtomicInt(&state->applied_seek_serial) != state->seek_serial) {
+        return state->requested_position;
+    }
+    return atomic_s64_get(&state->playback_position);
+}
+
+Sint64 audio_state_get_audible_position(AudioState *state, Uint64 now_ns) {
     if (!state) return 0;
-    return SDL_GetAtomicInt(&state->playback_position);
+    // The grains follow the pointer closely enough to draw it directly
+    if (state->scrubbing) {
+        return state->scrub_position;
+    }
+    if ((Uint32)SDL_GetAtomicInt(&state->applied_seek_serial) != state->seek_serial) {
+        return state->requested_position;
+    }
+    if (state->playback_state == PLAYBACK_PAUSED) {
+        return state->held_position;
+    }
+    if (state->playback_state != PLAYBACK_PLAYING) {
+        return atomic_s64_get(&state->playback_position);
+    }
+
+    // Copy the anchor, retrying if the callback was writing it meanwhile
+    PlaybackClock *clock = &state->clock;
+    Sint64 frame, span, time_ns, loop_start, loop_end;
+    Uint32 play_serial;
+    int sequence;
+    do {
+        sequence = SDL_GetAtomicInt(&clock->sequence);
+        frame = atomic_s64_get(&clock->frame);
+        span = atomic_s64_get(&clock->span);
+        time_ns = atomic_s64_get(&clock->time_ns);
+        loop_start = atomic_s64_get(&clock->loop_start);
+        loop_end = atomic_s64_get(&clock->loop_end);
+        play_serial = (Uint32)SDL_GetAtomicInt(&clock->play_serial);
+    } while ((sequence & 1) || sequence != SDL_GetAtomicInt(&clock->sequence));
+
+    // Nothing pulled since the last play: the first pull starts from here
+    if (play_serial != state->play_serial) {
+        return state->held_position;
+    }
+
+    // May run backwards from an anchor that isn't audible yet. Never runs
+    // past the frames queued with the anchor: the next pull re-anchors
+    // before they have played, unless it had nothing to queue (waiting for
+    // the decoder), and then the playhead stops where the audio did.
+    const double elapsed_s = (double)((Sint64)now_ns - time_ns) / SDL_NS_PER_SECOND;
+    Sint64 advance = (Sint64)(elapsed_s * state->sample_rate);
+    if (advance > span) {
+        advance = span;
+    }
+    Sint64 position = frame + advance;
+    const Sint64 loop_length = loop_end - loop_start;
+    if (loop_length > 0) {
+        if (position >= loop_end) {
+            position = loop_start + (position - loop_start) % loop_length;
+        } else if (position < loop_start) {
+            position = loop_end - 1 - (loop_start - 1 - position) % loop_length;
+        }
+    }
+    return position;
+}
+
+// Convert a frame count on the timeline to seconds. This is the only place
+// where frame positions are turned into time.
+double audio_state_frames_to_seconds(const AudioState *state, Sint64 frames) {
+    if (!state || state->sample_rate <= 0) return 0.0;
+    return (double)frames / (double)state->sample_rate;
 }
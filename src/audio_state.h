@@ -23,6 +23,12 @@
 #include "../libs/SDL_sound/include/SDL3_sound/SDL_sound.h"
 #include "audio_tools/beat_track.h"
 #include "audio_tools/audio_io.h"
+#include "atomic64.h"
+#include "pcm_buffer.h"
+#include "analysis_cache.h"
+#include "playback_queue.h"
+#include "playback_ring.h"
+#include "dsp/scrub.h"
 
 // Status enum (moved from main.c)
 typedef enum {
@@ -39,58 +45,225 @@ typedef enum {
     PLAYBACK_PAUSED
 } PlaybackState;
 
+// Which frame is audible when, published by the audio callback after each
+// pull so the UI can extrapolate the playhead between pulls. Written and
+// read under a sequence lock: `sequence` is odd while a write is underway.
+typedef struct {
+    SDL_AtomicInt sequence;
+    AtomicS64 frame;             // Frame heard at time_ns
+    AtomicS64 span;              // Frames queued from `frame` on, before any silence
+    AtomicS64 time_ns;           // In SDL_GetTicksNS() time
+    AtomicS64 loop_start;        // Loop region the frames after it wrap in
+    AtomicS64 loop_end;
+    SDL_AtomicInt play_serial;   // PLAY command the anchor belongs to
+} PlaybackClock;
+
+// What the playback feeder reads ahead, published by the audio callback.
+// A new generation restarts reading at `frame`; the loop region can change
+// under the same one. Sequence-locked like PlaybackClock.
+typedef struct {
+    SDL_AtomicInt sequence;
+    SDL_AtomicInt generation;
+    AtomicS64 frame;
+    AtomicS64 loop_start;
+    AtomicS64 loop_end;
+} PlaybackFeed;
+
+// A file load running on its own thread (private to audio_state.c)
+typedef struct ProcessingJob ProcessingJob;
+
 // Main audio state structure (consolidates AudioTrack + adds playback)
 typedef struct {
     // File and decoding
     char *file_path;
-    Sound_Sample *sample;
+    bool headless;                 // Batch mode: no playback device, no PCM cache writes
+    Uint32 load_generation;        // Bumped on every load so views can tell files apart
+
+    // Decoded audio, filled chunk by chunk by the decoder. This is the only
+    // copy of the PCM: the waveform, the beat analysis and playback all
+    // borrow it. The pointer is swapped under data_mutex when the decoder
+    // grows the buffer; take a reference with audio_state_acquire_pcm().
+    //
+    // All timeline positions below (beats, selection, playback) are frame
+    // indices: one frame holds one sample per channel. They are 64-bit so
+    // multi-hour recordings don't overflow.
+    PcmBuffer *pcm;
+    Sint64 loaded_frames;          // Loader's length: estimated while decoding, exact once done
+    Sint64 total_frames;           // UI thread's copy of loaded_frames, see audio_state_sync_playback()
+    int sample_rate;
+    int channels;
     
-    // Beat detection
-    unsigned int *beat_positions;
+    // Beat detection. Published once, when analysis finishes, and only freed
+    // from the main thread. beat_positions points into `analysis`.
+    const Sint64 *beat_positions;
     int beat_count;
-    int beats_buffer_size;
+    AnalysisData *analysis;        // Tempo, beats and cached peaks
     
     // Processing state
     AudioStatus status;
-    SDL_Thread *processing_thread;
+    ProcessingJob *job;            // Load in progress, NULL when idle
+    SDL_AtomicInt live_jobs;       // Processing threads still running, cancelled ones included
+    SDL_AtomicInt refs;            // The owner's reference plus one per live job
     SDL_Mutex *data_mutex;
-    SDL_AtomicInt request_stop;
-    float processing_progress;
+    SDL_Mutex *analysis_mutex;     // Held by the one job running beat tracking
+    float processing_progress;     // 0..1 across all stages, protected by data_mutex
+    bool progress_indeterminate;   // The current stage can't report progress, protected by data_mutex
     
-    // Playback state (NEW - for real-time sound playback)
+    // Playback state (NEW - for real-time sound playback). playback_state
+    // is the UI thread's; the callback follows it through `commands`.
     PlaybackState playback_state;
-    SDL_AtomicInt playback_position;  // Current sample position during playback (atomic for thread safety)
+    AtomicS64 playback_position;  // Published by the audio callback after each pull
     bool follow_playback;    // Auto-scroll during playback
     
     // Audio streaming
     SDL_AudioStream *audio_stream;
     SDL_AudioDeviceID audio_device;
-    float *playback_buffer;  // Copy of audio data for playback
-    size_t playback_buffer_size;
+    PcmBuffer *playback_pcm; // Reference to pcm the audio callback scrubs through
+    PcmBuffer *offered_pcm;  // UI thread's reference to the pcm last given to playback
+    // Hand-offs between the callback and the UI thread when the decoder
+    // moves into a bigger buffer, so the callback neither locks nor frees:
+    // the UI offers the new buffer in incoming_pcm, the callback swaps it
+    // in and leaves the old one in retired_pcm for the UI to release.
+    PcmBuffer *incoming_pcm;
+    PcmBuffer *retired_pcm;
+    Sint64 device_latency_ns; // One device buffer: queued audio to the speaker
+    PlaybackClock clock;
+
+    // Read-ahead for linear playback. The feeder thread copies the loop
+    // region from the decoded buffer into `ring`, wrapping as the callback
+    // would, and the callback plays from the ring only, so what it touches
+    // is bounded whatever the file's length. The feeder runs while the
+    // device is open and sleeps on feeder_wake while the ring is full.
+    PlaybackRing ring;
+    PlaybackFeed feed;
+    SDL_Thread *feeder;
+    SDL_Semaphore *feeder_wake;
+    SDL_AtomicInt feeder_quit;
+    SDL_AtomicInt starved_generation;  // Feed the feeder has read up to the decoder in, or 0
+
+    // Audio callback duration for the performance overlay, in nanoseconds.
+    // Only published while callback_timing is non-zero.
+    SDL_AtomicInt callback_timing;
+    SDL_AtomicInt callback_last_ns;
+    SDL_AtomicInt callback_peak_ns;  // Longest since the reader last reset it
+    SDL_AtomicInt xrun_count;        // Callbacks that dropped available audio or overran their buffer's duration
+
+    // Selection, owned by the UI thread. Change it with
+    // audio_state_set_selection() so playback loops over the new region.
+    // Until then it follows total_frames to cover the whole file, and a
+    // selection made while the file loads is kept.
+    Sint64 selection_start;
+    Sint64 selection_end;
+    bool selection_user_set;
+
+    // Transport changes for the audio callback, pushed by the UI thread
+    // only. Seeks and loop changes are coalesced and pushed by
+    // audio_state_sync_playback(), at most one of each per call.
+    PlaybackQueue commands;
+    bool loop_dirty;                    // Send the loop even if it looks unchanged
+    Sint64 pushed_loop_start;           // Loop region last pushed
+    Sint64 pushed_loop_end;
+    bool seek_dirty;
+    Uint32 seek_serial;                 // Last seek requested
+    Sint64 requested_position;          // Its target, reported until it's applied
+    SDL_AtomicInt applied_seek_serial;  // Last seek the callback applied
+    Uint32 play_serial;                 // Last PLAY command pushed
+    Sint64 held_position;               // Shown while paused, or playing before the clock catches up
+
+    // Scrubbing. The pointer position goes straight to the callback through
+    // scrub_target, so each drag event is one atomic store; the callback
+    // reads the latest one per pull.
+    bool scrubbing;
+    Sint64 scrub_position;              // Pointer position, shown as the playhead
+    AtomicS64 scrub_target;
+    Uint32 scrub_serial;                // Last scrub begun
+    bool scrub_pausing;                 // Pause the device once the last grains have played
+    SDL_AtomicInt finished_scrub_serial; // Last scrub whose grains have all played
 
-    // Selection
-    unsigned int selection_start;
-    unsigned int selection_end;
+    // The audio callback's own copy of the transport, changed only by
+    // commands applied at the start of each pull
+    PlaybackState engine_state;
+    Sint64 loop_start;
+    Sint64 loop_end;
+    Uint32 engine_seek_serial;
+    Uint32 engine_play_serial;
+    Uint32 engine_scrub_serial;
+    int engine_feed_generation;         // Last feed request published
+    Sint64 engine_feed_next;            // Frame its next block should start at
+    bool engine_feed_started;           // A block of it has arrived
+    ScrubEngine scrub;
     
 } AudioState;
 
 // Function declarations
 AudioState* audio_state_create(void);
 void audio_state_destroy(AudioState *state);
+
+// Start loading a file in the background. Any load in progress is
+// cancelled; neither call waits for the processing thread.
 void audio_state_load_file(AudioState *state, const char *file_path);
 void audio_state_request_stop(AudioState *state);
-void audio_state_cleanup_processing(AudioState *state);
 
-// Playback functions
+// Cancel processing and wait up to timeout_ms for every processing thread to
+// exit. Returns false if one is still running.
+bool audio_state_cleanup_processing(AudioState *state, Uint32 timeout_ms);
+
+// Decode and analyse a file on the calling thread, through the same
+// pipeline and caches as audio_state_load_file. Meant for headless states
+// (see batch.c). Returns true once the state holds the file's audio and
+// analysis.
+bool audio_state_process_file(AudioState *state, const char *file_path);
+
+// Open a file for decoding the way the pipeline does. A caller that needs
+// its header first (batch.c budgets memory from it) hands the sample on to
+// audio_state_process_sample, which takes ownership of it, so the file is
+// opened once. The sample is only decoded from if the PCM cache misses.
+Sound_Sample* audio_state_open_sample(const char *file_path);
+
+// Rough peak memory used to process `frames` frames: the decoded audio, the
+// analysis signal, the waveform pyramid and, while CARA runs, its STFT and
+// mel spectrogram of the analysis signal
+Sint64 audio_state_estimate_bytes(Sint64 frames, int channels, int sample_rate);
+bool audio_state_process_sample(AudioState *state, const char *file_path,
+                                Sound_Sample *sample);
+
+// Playback functions. Playback is possible as soon as the first decoded
+// chunk is published, while the rest decodes and analysis runs.
+bool audio_state_can_play(AudioState *state);
 bool audio_state_start_playback(AudioState *state);
 void audio_state_stop_playback(AudioState *state);
 void audio_state_pause_playback(AudioState *state);
 void audio_state_resume_playback(AudioState *state);
-void audio_state_set_playback_position(AudioState *state, unsigned int position);
-unsigned int audio_state_get_playback_position(AudioState *state);
+void audio_state_set_playback_position(AudioState *state, Sint64 frame);
+Sint64 audio_state_get_playback_position(AudioState *state);
+
+// The frame being heard at `now_ns` (SDL_GetTicksNS() time), extrapolated
+// from the callback's last pull. Use this to draw the playhead.
+Sint64 audio_state_get_audible_position(AudioState *state, Uint64 now_ns);
+
+// Scrub while the playhead is dragged: the callback plays short crossfaded
+// grains around `frame` at the speed it moves, whether or not playback is
+// running. Ending continues playback from the last position if it was
+// playing. begin returns false if nothing can be played yet.
+bool audio_state_begin_scrub(AudioState *state, Sint64 frame);
+void audio_state_scrub_to(AudioState *state, Sint64 frame);
+void audio_state_end_scrub(AudioState *state);
+
+// Set the selection, which is also the playback loop region
+void audio_state_set_selection(AudioState *state, Sint64 start, Sint64 end);
+
+// Pick up what the loader has published (the file's length, and the buffer
+// playback reads from), then hand coalesced seek and loop changes to the
+// audio callback. Call once per main loop iteration, before reading
+// total_frames or the selection; while playback isn't running the changes
+// wait for the next play.
+void audio_state_sync_playback(AudioState *state);
+
+// Borrow the decoded audio. Returns NULL if nothing has been decoded yet;
+// release the result with pcm_buffer_release().
+PcmBuffer* audio_state_acquire_pcm(AudioState *state);
 
-// Audio conversion functions
-audio_data* sdl_sound_to_cara_audio(Sound_Sample *sample);
-void free_cara_audio(audio_data *audio);
+// Timeline helpers
+double audio_state_frames_to_seconds(const AudioState *state, Sint64 frames);
 
 #endif // AUDIO_STATE_H
@@ -0,0 +1,423 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Headless batch analysis. Decodes and beat-tracks audio files, or every
+// audio file under the given directories, on several threads, and writes
+// tempo and beat times per file as JSON or CSV. Each worker drives its own
+// headless AudioState through the same pipeline and caches as the GUI, so
+// libraries analysed overnight open instantly in the app afterwards.
+//
+// Usage: automarker-batch [-j threads] [-m max_memory_mb] [-f json|csv]
+//                         [-o output_file] path...
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <cJSON.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../libs/SDL_sound/include/SDL3_sound/SDL_sound.h"
+#include "audio_state.h"
+
+// Decoded audio allowed in flight across all workers
+#define DEFAULT_MAX_MEMORY_MB 2048
+
+// Decoded bytes assumed per input byte when a file can't report its duration
+#define UNKNOWN_DURATION_EXPANSION 12
+
+typedef enum {
+  OUTPUT_JSON,
+  OUTPUT_CSV
+} OutputFormat;
+
+typedef struct {
+  char **paths;
+  int count;
+  int capacity;
+} FileList;
+
+// Caps the decoded audio held by all workers together. A file bigger than
+// the whole budget still runs, alone.
+typedef struct {
+  SDL_Mutex *mutex;
+  SDL_Condition *released;
+  Sint64 limit;
+  Sint64 in_use;
+} MemoryBudget;
+
+typedef struct {
+  FileList files;
+  SDL_AtomicInt next_file;
+  MemoryBudget budget;
+  OutputFormat format;
+  FILE *output;
+
+  // Protected by output_mutex
+  SDL_Mutex *output_mutex;
+  int done;
+  int failed;
+  double audio_seconds;
+} Batch;
+
+// --- Input files ---
+
+static const Sound_DecoderInfo **decoders;
+
+static bool has_audio_extension(const char *path) {
+  const char *dot = SDL_strrchr(path, '.');
+  if (!dot) return false;
+
+  for (const Sound_DecoderInfo **info = decoders; *info != NULL; info++) {
+    for (const char **ext = (*info)->extensions; *ext != NULL; ext++) {
+      if (SDL_strcasecmp(dot + 1, *ext) == 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static bool add_file(FileList *list, const char *path) {
+  if (list->count == list->capacity) {
+    int capacity = list->capacity ? list->capacity * 2 : 64;
+    char **paths = SDL_realloc(list->paths, sizeof(char *) * capacity);
+    if (!paths) return false;
+    list->paths = paths;
+    list->capacity = capacity;
+  }
+
+  list->paths[list->count] = SDL_strdup(path);
+  if (!list->paths[list->count]) return false;
+  list->count++;
+  return true;
+}
+
+static void add_path(FileList *list, const char *path);
+
+static SDL_EnumerationResult SDLCALL add_directory_entry(void *userdata,
+                                                         const char *dirname,
+                                                         const char *fname) {
+  char *path = NULL;
+  if (SDL_asprintf(&path, "%s%s", dirname, fname) < 0) {
+    return SDL_ENUM_FAILURE;
+  }
+  add_path(userdata, path);
+  SDL_free(path);
+  return SDL_ENUM_CONTINUE;
+}
+
+// Add a file, or every audio file under a directory
+static void add_path(FileList *list, const char *path) {
+  SDL_PathInfo info;
+  if (!SDL_GetPathInfo(path, &info)) {
+    fprintf(stderr, "Warning: Skipping %s: %s\n", path, SDL_GetError());
+    return;
+  }
+
+  if (info.type == SDL_PATHTYPE_DIRECTORY) {
+    SDL_EnumerateDirectory(path, add_directory_entry, list);
+  } else if (info.type == SDL_PATHTYPE_FILE && has_audio_extension(path)) {
+    if (!add_file(list, path)) {
+      fprintf(stderr, "Warning: Out of memory, skipping %s\n", path);
+    }
+  }
+}
+
+static int SDLCALL compare_paths(const void *a, const void *b) {
+  return SDL_strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// --- Memory budget ---
+
+// Memory needed to process a file, from its header. A file that doesn't
+// open fails in the pipeline too and needs nothing.
+static Sint64 estimate_decoded_bytes(const char *path, Sound_Sample *sample) {
+  if (!sample) return 0;
+
+  const int channels = sample->actual.channels;
+  Sint64 frames = 0;
+  Sint32 duration_ms = Sound_GetDuration(sample);
+  if (duration_ms > 0) {
+    frames = (Sint64)duration_ms * sample->actual.rate / 1000;
+  } else {
+    SDL_PathInfo info;
+    if (SDL_GetPathInfo(path, &info)) {
+      frames = (Sint64)info.size * UNKNOWN_DURATION_EXPANSION /
+               (channels * (Sint64)sizeof(float));
+    }
+  }
+
+  return audio_state_estimate_bytes(frames, channels, (int)sample->actual.rate);
+}
+
+static void budget_acquire(MemoryBudget *budget, Sint64 bytes) {
+  SDL_LockMutex(budget->mutex);
+  while (budget->in_use > 0 && budget->in_use + bytes > budget->limit) {
+    SDL_WaitCondition(budget->released, budget->mutex);
+  }
+  budget->in_use += bytes;
+  SDL_UnlockMutex(budget->mutex);
+}
+
+static void budget_release(MemoryBudget *budget, Sint64 bytes) {
+  SDL_LockMutex(budget->mutex);
+  budget->in_use -= bytes;
+  SDL_BroadcastCondition(budget->released);
+  SDL_UnlockMutex(budget->mutex);
+}
+
+// --- Output ---
+
+static void write_csv_field(FILE *out, const char *text) {
+  fputc('"', out);
+  for (const char *c = text; *c; c++) {
+    if (*c == '"') fputc('"', out);
+    fputc(*c, out);
+  }
+  fputc('"', out);
+}
+
+static void write_csv(FILE *out, const char *path, const AudioState *state,
+                      double tempo_bpm) {
+  if (state->beat_count == 0) {
+    write_csv_field(out, path);
+    fprintf(out, ",%.3f,,\n", tempo_bpm);
+  }
+  for (int i = 0; i < state->beat_count; i++) {
+    write_csv_field(out, path);
+    fprintf(out, ",%.3f,%d,%.6f\n", tempo_bpm, i,
+            audio_state_frames_to_seconds(state, state->beat_positions[i]));
+  }
+}
+
+static void write_json(FILE *out, const char *path, const AudioState *state,
+                       double tempo_bpm, bool first) {
+  cJSON *entry = cJSON_CreateObject();
+  if (!entry) return;
+
+  cJSON_AddStringToObject(entry, "file", path);
+  if (state) {
+    cJSON_AddNumberToObject(entry, "sample_rate", state->sample_rate);
+    cJSON_AddNumberToObject(entry, "duration",
+                            audio_state_frames_to_seconds(state, state->total_frames));
+    cJSON_AddNumberToObject(entry, "tempo_bpm", tempo_bpm);
+
+    cJSON *beats = cJSON_AddArrayToObject(entry, "beats");
+    for (int i = 0; beats && i < state->beat_count; i++) {
+      cJSON_AddItemToArray(beats, cJSON_CreateNumber(
+          audio_state_frames_to_seconds(state, state->beat_positions[i])));
+    }
+  } else {
+    cJSON_AddStringToObject(entry, "error", "Could not decode or analyse file");
+  }
+
+  char *text = cJSON_PrintUnformatted(entry);
+  if (text) {
+    fprintf(out, "%s  %s", first ? "" : ",\n", text);
+    cJSON_free(text);
+  }
+  cJSON_Delete(entry);
+}
+
+// Record one file's result. `state` is NULL if it failed.
+static void write_result(Batch *batch, const char *path, const AudioState *state) {
+  const double tempo_bpm = state && state->analysis ? state->analysis->tempo_bpm : 0.0;
+
+  SDL_LockMutex(batch->output_mutex);
+  if (batch->format == OUTPUT_JSON) {
+    write_json(batch->output, path, state, tempo_bpm, batch->done == 0);
+  } else if (state) {
+    write_csv(batch->output, path, state, tempo_bpm);
+  }
+
+  batch->done++;
+  if (state) {
+    batch->audio_seconds += audio_state_frames_to_seconds(state, state->total_frames);
+    fprintf(stderr, "[%d/%d] %s: %d beats, %.2f BPM\n", batch->done,
+            batch->files.count, path, state->beat_count, tempo_bpm);
+  } else {
+    batch->failed++;
+    fprintf(stderr, "[%d/%d] %s: failed\n", batch->done, batch->files.count, path);
+  }
+  SDL_UnlockMutex(batch->output_mutex);
+}
+
+// --- Workers ---
+
+static int batch_worker(void *data) {
+  Batch *batch = data;
+
+  AudioState *state = audio_state_create();
+  if (!state) {
+    fprintf(stderr, "Error: Could not create audio state\n");
+    return 1;
+  }
+  state->headless = true;
+
+  for (;;) {
+    int index = SDL_AddAtomicInt(&batch->next_file, 1);
+    if (index >= batch->files.count) break;
+    const char *path = batch->files.paths[index];
+
+    // The pipeline decodes from this sample, so the header is only read once
+    Sound_Sample *sample = audio_state_open_sample(path);
+    const Sint64 bytes = estimate_decoded_bytes(path, sample);
+    budget_acquire(&batch->budget, bytes);
+
+    bool completed = audio_state_process_sample(state, path, sample);
+    write_result(batch, path, completed ? state : NULL);
+
+    // Drop the audio before handing its memory back to the budget
+    audio_state_request_stop(state);
+    budget_release(&batch->budget, bytes);
+  }
+
+  audio_state_destroy(state);
+  return 0;
+}
+
+static void print_usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [options] path...\n"
+          "Analyse audio files, or all audio files under directories.\n\n"
+          "  -j threads        Files analysed at once (default: logical cores)\n"
+          "  -m megabytes      Memory for files in flight: decoded audio, analysis\n"
+          "                    signal, waveform peaks and beat tracking's\n"
+          "                    spectrograms (default: %d)\n"
+          "  -f json|csv       Output format (default: json)\n"
+          "  -o file           Output file (default: beats.json or beats.csv)\n",
+          program, DEFAULT_MAX_MEMORY_MB);
+}
+
+int main(int argc, char *argv[]) {
+  Batch batch;
+  SDL_zero(batch);
+  batch.format = OUTPUT_JSON;
+  batch.budget.limit = (Sint64)DEFAULT_MAX_MEMORY_MB * 1024 * 1024;
+  int threads = SDL_GetNumLogicalCPUCores();
+  const char *output_path = NULL;
+
+  int first_path = 1;
+  for (; first_path < argc && argv[first_path][0] == '-'; first_path++) {
+    const char *option = argv[first_path];
+    const char *value = first_path + 1 < argc ? argv[first_path + 1] : NULL;
+    if (SDL_strcmp(option, "-h") == 0 || SDL_strcmp(option, "--help") == 0) {
+      print_usage(argv[0]);
+      return 0;
+    }
+    if (!value) {
+      print_usage(argv[0]);
+      return 1;
+    }
+
+    if (SDL_strcmp(option, "-j") == 0) {
+      threads = SDL_atoi(value);
+    } else if (SDL_strcmp(option, "-m") == 0) {
+      batch.budget.limit = (Sint64)SDL_atoi(value) * 1024 * 1024;
+    } else if (SDL_strcmp(option, "-f") == 0 && SDL_strcmp(value, "csv") == 0) {
+      batch.format = OUTPUT_CSV;
+    } else if (SDL_strcmp(option, "-f") == 0 && SDL_strcmp(value, "json") == 0) {
+      batch.format = OUTPUT_JSON;
+    } else if (SDL_strcmp(option, "-o") == 0) {
+      output_path = value;
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+    first_path++;
+  }
+  if (first_path >= argc || threads < 1 || batch.budget.limit <= 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  if (!Sound_Init()) {
+    fprintf(stderr, "Error: Could not initialise SDL_sound: %s\n", SDL_GetError());
+    return 1;
+  }
+  decoders = Sound_AvailableDecoders();
+
+  for (int i = first_path; i < argc; i++) {
+    add_path(&batch.files, argv[i]);
+  }
+  if (batch.files.count == 0) {
+    fprintf(stderr, "No audio files found\n");
+    Sound_Quit();
+    return 1;
+  }
+  SDL_qsort(batch.files.paths, batch.files.count, sizeof(char *), compare_paths);
+
+  if (!output_path) {
+    output_path = batch.format == OUTPUT_JSON ? "beats.json" : "beats.csv";
+  }
+  batch.output = fopen(output_path, "w");
+  batch.output_mutex = SDL_CreateMutex();
+  batch.budget.mutex = SDL_CreateMutex();
+  batch.budget.released = SDL_CreateCondition();
+  if (!batch.output || !batch.output_mutex || !batch.budget.mutex ||
+      !batch.budget.released) {
+    fprintf(stderr, "Error: Could not open %s\n", output_path);
+    Sound_Quit();
+    return 1;
+  }
+  fputs(batch.format == OUTPUT_JSON ? "[\n" : "file,tempo_bpm,beat,time_seconds\n",
+        batch.output);
+
+  if (threads > batch.files.count) {
+    threads = batch.files.count;
+  }
+  const Uint64 start_ns = SDL_GetTicksNS();
+  SDL_Thread **workers = SDL_calloc((size_t)threads, sizeof(SDL_Thread *));
+  int started = 0;
+  for (int i = 0; workers && i < threads; i++) {
+    workers[i] = SDL_CreateThread(batch_worker, "BatchWorker", &batch);
+    if (workers[i]) started++;
+  }
+  if (started == 0) {
+    batch_worker(&batch);
+  }
+  for (int i = 0; workers && i < threads; i++) {
+    SDL_WaitThread(workers[i], NULL);
+  }
+  SDL_free(workers);
+  const double elapsed = (double)(SDL_GetTicksNS() - start_ns) / SDL_NS_PER_SECOND;
+
+  if (batch.format == OUTPUT_JSON) {
+    fputs("\n]\n", batch.output);
+  }
+  fclose(batch.output);
+
+  fprintf(stderr,
+          "Analysed %d files (%.1f min of audio) in %.1f s on %d threads: "
+          "%.1fx real time, %d failed. Results in %s\n",
+          batch.done - batch.failed, batch.audio_seconds / 60.0, elapsed,
+          started ? started : 1,
+          elapsed > 0.0 ? batch.audio_seconds / elapsed : 0.0,
+          batch.failed, output_path);
+
+  SDL_DestroyCondition(batch.budget.released);
+  SDL_DestroyMutex(batch.budget.mutex);
+  SDL_DestroyMutex(batch.output_mutex);
+  for (int i = 0; i < batch.files.count; i++) {
+    SDL_free(batch.files.paths[i]);
+  }
+  SDL_free(batch.files.paths);
+  Sound_Quit();
+
+  return batch.failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef BEAT_INDEX_H
+#define BEAT_INDEX_H
+
+#include <SDL3/SDL.h>
+
+// Lookups into a sorted array of beat positions (frame indices). Beats are
+// kept in ascending order from the tracker through the analysis sidecar,
+// so the visible or selected range is found by bisection instead of a scan.
+
+// Index of the first beat at or after `frame`, or count if there is none
+static inline int beat_index_lower_bound(const Sint64 *beats, int count, Sint64 frame) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (beats[mid] < frame) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Index of the first beat after `frame`, or count if there is none
+static inline int beat_index_upper_bound(const Sint64 *beats, int count, Sint64 frame) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (beats[mid] <= frame) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+#endif // BEAT_INDEX_H
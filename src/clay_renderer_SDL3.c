@@ -18,18 +18,318 @@
  */
 
 #include "clay_renderer_SDL3.h"
+#include "beat_index.h"
 #include <SDL3_image/SDL_image.h>
 #include <math.h>
 #include <stdlib.h>
 
+// Make room for `columns` columns of two quads each
+static bool ReserveWaveformGeometry(WaveformGeometry *geometry, int columns) {
+    if (columns <= geometry->columnCapacity) return true;
+
+    SDL_Vertex *vertices = SDL_realloc(geometry->vertices, (size_t)columns * 8 * sizeof(SDL_Vertex));
+    if (!vertices) return false;
+    geometry->vertices = vertices;
+
+    int *indices = SDL_realloc(geometry->indices, (size_t)columns * 12 * sizeof(int));
+    if (!indices) return false;
+    geometry->indices = indices;
+
+    geometry->columnCapacity = columns;
+    return true;
+}
+
+static bool ReserveWaveformMarkers(WaveformGeometry *geometry, int markers) {
+    if (markers <= geometry->markerCapacity) return true;
+
+    SDL_FRect *rects = SDL_realloc(geometry->markers, (size_t)markers * sizeof(SDL_FRect));
+    if (!rects) return false;
+    geometry->markers = rects;
+    geometry->markerCapacity = markers;
+    return true;
+}
+
+// Append a 1px wide quad spanning [top, bottom], at least 1px tall
+static void AddWaveformQuad(WaveformGeometry *geometry, int *vertexCount, int *indexCount,
+                            float left, float top, float bottom, SDL_FColor color) {
+    if (bottom - top < 1.0f) bottom = top + 1.0f;
+
+    const int base = *vertexCount;
+    SDL_Vertex *v = &geometry->vertices[base];
+    v[0] = (SDL_Vertex){ {left, top}, color, {0, 0} };
+    v[1] = (SDL_Vertex){ {left + 1.0f, top}, color, {1, 0} };
+    v[2] = (SDL_Vertex){ {left + 1.0f, bottom}, color, {1, 1} };
+    v[3] = (SDL_Vertex){ {left, bottom}, color, {0, 1} };
+    *vertexCount += 4;
+
+    int *i = &geometry->indices[*indexCount];
+    i[0] = base; i[1] = base + 1; i[2] = base + 3;
+    i[3] = base + 1; i[4] = base + 2; i[5] = base + 3;
+    *indexCount += 6;
+}
+
+// Frames that can be drawn: the decoded ones, or more while the peaks of a
+// cached file are ahead of its samples
+static Sint64 DrawableFrames(const WaveformData *data) {
+    return data->peakFrames > data->decodedFrames ? data->peakFrames : data->decodedFrames;
+}
+
+// Draw `width` columns starting at (left, top), column x covering frames
+// from startFrame + x * framesPerPixel. Only frames before `available` are
+// drawn.
+//
+// Each column shows the true min..max of the frames under it, with the
+// RMS as a brighter core. The pyramid level is picked so a column reads
+// one or two entries, which keeps the cost O(width) at any zoom. Columns
+// are emitted as quads into one vertex buffer and drawn with a single
+// SDL_RenderGeometry call.
+static void RenderWaveformColumns(Clay_SDL3RendererData *rendererData, const WaveformData *data,
+                                  float left, float top, int width, int height,
+                                  Sint64 startFrame, double framesPerPixel, Sint64 available) {
+    WaveformGeometry *geometry = &rendererData->waveformGeometry;
+    if (!ReserveWaveformGeometry(geometry, width)) return;
+
+    const int level = waveform_pyramid_level_for(data->peaks, framesPerPixel);
+    const float halfHeight = height / 2.0f;
+    const float centerY = top + halfHeight;
+    const SDL_FColor peakColor = {
+        data->lineColor.r / 255, data->lineColor.g / 255,
+        data->lineColor.b / 255, data->lineColor.a / 255};
+    const SDL_FColor rmsColor = {
+        peakColor.r + (1.0f - peakColor.r) * 0.5f,
+        peakColor.g + (1.0f - peakColor.g) * 0.5f,
+        peakColor.b + (1.0f - peakColor.b) * 0.5f,
+        peakColor.a};
+    int vertexCount = 0, indexCount = 0;
+
+    for (int x = 0; x < width; x++) {
+        // Frames [from, to) fall under this column. Zoomed in past one
+        // frame per pixel, neighbouring columns share a frame.
+        Sint64 from = startFrame + (Sint64)(x * framesPerPixel);
+        Sint64 to = startFrame + (Sint64)((x + 1) * framesPerPixel);
+        if (to <= from) to = from + 1;
+        if (from >= available) break;
+
+        WaveformPeak peak;
+        if (data->peaks) {
+            if (!waveform_pyramid_query(data->peaks, data->samples, data->channels,
+                                        SDL_min(available, data->decodedFrames),
+                                        level, from, to, &peak)) {
+                continue;
+            }
+        } else {
+            const float *frame = &data->samples[from * data->channels];
+            float sampleValue = 0.0f;
+            for (int c = 0; c < data->channels; c++) {
+                sampleValue += frame[c];
+            }
+            sampleValue /= data->channels;
+            peak = (WaveformPeak){sampleValue, sampleValue, fabsf(sampleValue)};
+        }
+
+        const float columnX = left + x;
+        if (framesPerPixel <= 1.0) {
+            // One frame per column: draw the sample itself from the center line
+            float y = centerY - peak.max * halfHeight;
+            AddWaveformQuad(geometry, &vertexCount, &indexCount, columnX,
+                            SDL_min(y, centerY), SDL_max(y, centerY), peakColor);
+            continue;
+        }
+
+        AddWaveformQuad(geometry, &vertexCount, &indexCount, columnX,
+                        centerY - peak.max * halfHeight,
+                        centerY - peak.min * halfHeight, peakColor);
+
+        float rmsTop = peak.rms < peak.max ? peak.rms : peak.max;
+        float rmsBottom = -peak.rms > peak.min ? -peak.rms : peak.min;
+        if (rmsTop > rmsBottom) {
+            AddWaveformQuad(geometry, &vertexCount, &indexCount, columnX,
+                            centerY - rmsTop * halfHeight,
+                            centerY - rmsBottom * halfHeight, rmsColor);
+        }
+    }
+
+    if (indexCount > 0) {
+        SDL_RenderGeometry(rendererData->renderer, NULL,
+                           geometry->vertices, vertexCount,
+                           geometry->indices, indexCount);
+        rendererData->stats.drawCalls++;
+    }
+}
+
+void FreeWaveformGeometry(WaveformGeometry *geometry) {
+    SDL_free(geometry->vertices);
+    SDL_free(geometry->indices);
+    SDL_free(geometry->markers);
+    SDL_zerop(geometry);
+}
+
+// Below this many pixels per beat, beats are drawn as density bands
+#define BEAT_MIN_SPACING_PX 3
+
+// Finest tile exponent: a tile still spans at least one frame
+#define WAVEFORM_TILE_MIN_EXPONENT -8
+
+void FreeWaveformTiles(WaveformTileCache *cache) {
+    for (int i = 0; i < WAVEFORM_TILE_CACHE_SIZE; i++) {
+        if (cache->tiles[i].texture) {
+            SDL_DestroyTexture(cache->tiles[i].texture);
+        }
+    }
+    SDL_zerop(cache);
+}
+
+// Find tile (exponent, index), or claim the least recently used slot for it
+static WaveformTile* LookupWaveformTile(WaveformTileCache *cache, int exponent, Sint64 index) {
+    WaveformTile *victim = NULL;
+    for (int i = 0; i < WAVEFORM_TILE_CACHE_SIZE; i++) {
+        WaveformTile *tile = &cache->tiles[i];
+        if (tile->valid && tile->exponent == exponent && tile->index == index) {
+            return tile;
+        }
+        // Prefer empty slots, then the least recently used tile that is
+        // not already on screen this frame
+        if (!tile->valid) {
+            if (!victim || victim->valid) victim = tile;
+        } else if (tile->lastUsed != cache->clock &&
+                   (!victim || (victim->valid && tile->lastUsed < victim->lastUsed))) {
+            victim = tile;
+        }
+    }
+    if (victim) {
+        victim->valid = false;
+        victim->exponent = exponent;
+        victim->index = index;
+    }
+    return victim;
+}
+
+// Rasterise `tile` into its texture, creating it if needed
+static bool RasteriseWaveformTile(Clay_SDL3RendererData *rendererData, WaveformTileCache *cache,
+                                  WaveformTile *tile, const WaveformData *data) {
+    SDL_Renderer *renderer = rendererData->renderer;
+    if (!tile->texture) {
+        tile->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                          SDL_TEXTUREACCESS_TARGET,
+                                          WAVEFORM_TILE_WIDTH, cache->height);
+        if (!tile->texture) return false;
+        SDL_SetTextureBlendMode(tile->texture, SDL_BLENDMODE_BLEND);
+        // Tiles are only ever magnified, by less than 2x. At such fractional
+        // scales nearest sampling doubles some columns and not others, which
+        // shimmers while zooming; linear spreads each column evenly instead.
+        SDL_SetTextureScaleMode(tile->texture, SDL_SCALEMODE_LINEAR);
+    }
+
+    const double framesPerPixel = ldexp(1.0, tile->exponent);
+    const Sint64 tileFrames = (Sint64)(WAVEFORM_TILE_WIDTH * framesPerPixel);
+    const Sint64 tileStart = tile->index * tileFrames;
+
+    SDL_Texture *previousTarget = SDL_GetRenderTarget(renderer);
+    if (!SDL_SetRenderTarget(renderer, tile->texture)) return false;
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    RenderWaveformColumns(rendererData, data, 0, 0, WAVEFORM_TILE_WIDTH, cache->height,
+                          tileStart, framesPerPixel, DrawableFrames(data));
+    SDL_SetRenderTarget(renderer, previousTarget);
+
+    tile->decodedFrames = data->decodedFrames;
+    tile->valid = true;
+    return true;
+}
+
+// Draw the waveform from cached tiles. Returns false if tiles can't be
+// used, in which case nothing was drawn.
+static bool DrawWaveformTiles(Clay_SDL3RendererData *rendererData, SDL_FRect rect,
+                              const WaveformData *data, Sint64 startFrame, double framesPerPixel) {
+    WaveformTileCache *cache = &rendererData->waveformTiles;
+    const int height = rect.h;
+    if (height <= 0 || rect.w <= 0) return true;
+
+    // A new file or a new height makes every tile stale. The textures are
+    // kept when only the content changed.
+    if (cache->sourceId != data->sourceId || cache->height != height) {
+        for (int i = 0; i < WAVEFORM_TILE_CACHE_SIZE; i++) {
+            WaveformTile *tile = &cache->tiles[i];
+            tile->valid = false;
+            if (cache->height != height && tile->texture) {
+                SDL_DestroyTexture(tile->texture);
+                tile->texture = NULL;
+            }
+        }
+        cache->sourceId = data->sourceId;
+        cache->height = height;
+    }
+    cache->clock++;
+
+    // Round the zoom up to a power of two frames per column so tiles are
+    // shared between nearby zooms and only ever stretched, never shrunk
+    int exponent = (int)ceil(log2(framesPerPixel));
+    if (exponent < WAVEFORM_TILE_MIN_EXPONENT) exponent = WAVEFORM_TILE_MIN_EXPONENT;
+    const double tileFramesPerPixel = ldexp(1.0, exponent);
+    const Sint64 tileFrames = (Sint64)(WAVEFORM_TILE_WIDTH * tileFramesPerPixel);
+    const double scale = tileFramesPerPixel / framesPerPixel;
+
+    const Sint64 endFrame = startFrame + (Sint64)ceil(rect.w * framesPerPixel);
+    const Sint64 drawable = DrawableFrames(data);
+    const Sint64 lastFrame = (endFrame < drawable ? endFrame : drawable) - 1;
+    const Sint64 firstTile = startFrame / tileFrames;
+    const Sint64 lastTile = lastFrame >= startFrame ? lastFrame / tileFrames : firstTile - 1;
+    if (lastTile - firstTile + 1 > WAVEFORM_TILE_CACHE_SIZE) return false;
+
+    // Rasterise what is missing first, so the render target is back on the
+    // window before the clip rectangle for the blits is set
+    WaveformTile *visible[WAVEFORM_TILE_CACHE_SIZE];
+    int visibleCount = 0;
+    for (Sint64 index = firstTile; index <= lastTile; index++) {
+        WaveformTile *tile = LookupWaveformTile(cache, exponent, index);
+        if (!tile) return false;
+        tile->lastUsed = cache->clock;
+
+        // A tile that ran past the decoded frames is redrawn as they grow
+        const Sint64 tileEnd = (index + 1) * tileFrames;
+        bool stale = !tile->valid ||
+                     (tile->decodedFrames < tileEnd && tile->decodedFrames < data->decodedFrames);
+        if (stale && !RasteriseWaveformTile(rendererData, cache, tile, data)) {
+            return false;
+        }
+        visible[visibleCount++] = tile;
+    }
+
+    SDL_Renderer *renderer = rendererData->renderer;
+    SDL_Rect previousClip;
+    const bool wasClipped = SDL_RenderClipEnabled(renderer);
+    SDL_GetRenderClipRect(renderer, &previousClip);
+
+    SDL_Rect clip = {(int)rect.x, (int)rect.y, (int)rect.w, height};
+    if (wasClipped) {
+        SDL_GetRectIntersection(&clip, &previousClip, &clip);
+    }
+    SDL_SetRenderClipRect(renderer, &clip);
+
+    for (int i = 0; i < visibleCount; i++) {
+        const WaveformTile *tile = visible[i];
+        SDL_FRect dst = {
+            rect.x + (float)((double)(tile->index * tileFrames - startFrame) / framesPerPixel),
+            rect.y,
+            (float)(WAVEFORM_TILE_WIDTH * scale),
+            height};
+        SDL_RenderTexture(renderer, tile->texture, NULL, &dst);
+        rendererData->stats.drawCalls++;
+    }
+
+    SDL_SetRenderClipRect(renderer, wasClipped ? &previousClip : NULL);
+    return true;
+}
+
 // Function to draw a waveform
 void DrawWaveform(Clay_SDL3RendererData *rendererData, SDL_FRect rect, WaveformData *data) {
     // If no data or samples, draw a placeholder
-    if (!data || !data->samples || data->sampleCount <= 0) {
+    if (!data || !data->samples || data->frameCount <= 0 || data->channels <= 0) {
         // Draw a placeholder line to indicate no data
         SDL_SetRenderDrawColor(rendererData->renderer, 255, 0, 0, 255); // Red color for placeholder
         const float centerY = rect.y + rect.h / 2.0f;
         SDL_RenderLine(rendererData->renderer, rect.x, centerY, rect.x + rect.w, centerY);
+        rendererData->stats.drawCalls++;
         return;
     }
     
@@ -41,82 +341,99 @@ void DrawWaveform(Clay_SDL3RendererData *rendererData, SDL_FRect rect, WaveformD
     // Draw center line for reference
     SDL_SetRenderDrawColor(rendererData->renderer, 100, 100, 100, 255); // Gray color for center line
     SDL_RenderLine(rendererData->renderer, rect.x, centerY, rect.x + width, centerY);
-
-    // Fix: Calculate visible samples correctly for zoom levels
-    // When zoom = 1.0, show all samples
-    // When zoom > 1.0, show fewer samples (zoomed in)
-    // When zoom < 1.0, still show all samples but with different sampling
-    unsigned int visibleSamples;
+    rendererData->stats.drawCalls++;
+
+    // Fix: Calculate visible frames correctly for zoom levels
+    // When zoom = 1.0, show all frames
+    // When zoom > 1.0, show fewer frames (zoomed in)
+    // When zoom < 1.0, still show all frames but with different sampling
+    // Frame <-> pixel mapping is done in double: float can't address
+    // individual frames past ~6 minutes of audio.
+    Sint64 visibleFrames;
     if (data->currentZoom >= 1.0f) {
-        visibleSamples = (unsigned int)(data->sampleCount / data->currentZoom);
+        visibleFrames = (Sint64)((double)data->frameCount / data->currentZoom);
     } else {
-        visibleSamples = data->sampleCount; // Show all samples when zoomed out
+        visibleFrames = data->frameCount; // Show all frames when zoomed out
     }
+    if (visibleFrames < 1) visibleFrames = 1;
     
-    int maxStartSample = (data->sampleCount > (int)visibleSamples) ? (data->sampleCount - visibleSamples) : 0;
-    unsigned int startSample = (maxStartSample > 0) ? (unsigned int)(data->currentScroll * maxStartSample) : 0;
+    Sint64 maxStartFrame = (data->frameCount > visibleFrames) ? (data->frameCount - visibleFrames) : 0;
+    Sint64 startFrame = (Sint64)(data->currentScroll * (double)maxStartFrame);
     
     // Ensure we're within bounds
-    if (visibleSamples > (unsigned int)data->sampleCount) visibleSamples = data->sampleCount;
-    if (startSample + visibleSamples > (unsigned int)data->sampleCount) {
-        visibleSamples = data->sampleCount - startSample;
+    if (visibleFrames > data->frameCount) visibleFrames = data->frameCount;
+    if (startFrame + visibleFrames > data->frameCount) {
+        visibleFrames = data->frameCount - startFrame;
     }
-
-    SDL_SetRenderDrawColor(rendererData->renderer, 
-        data->lineColor.r, 
-        data->lineColor.g, 
-        data->lineColor.b, 
-        data->lineColor.a);
-    
-    for (int x = 0; x < width; x++) {
-        // Map x position to sample index
-        float samplePos = (float)x / width * visibleSamples;
-        int sampleIndex = startSample + (int)samplePos;
-        
-        // Ensure we're within bounds
-        if (sampleIndex >= 0 && sampleIndex < data->sampleCount) {
-            // Get sample value and normalize it
-            float sampleValue = data->samples[sampleIndex];
-            
-            float lineHeight = (sampleValue) * (height / 2.0f);
-            
-            // Draw vertical line representing the sample
-            SDL_RenderLine(rendererData->renderer, 
-                          rect.x + x, centerY, 
-                          rect.x + x, centerY - lineHeight);
-        }
+    const Sint64 endFrame = startFrame + visibleFrames;
+    const double framesPerPixel = (double)visibleFrames / width;
+
+    if (!DrawWaveformTiles(rendererData, rect, data, startFrame, framesPerPixel)) {
+        // No render target support: rasterise the visible range directly
+        const Sint64 drawable = DrawableFrames(data);
+        const Sint64 available = drawable < endFrame ? drawable : endFrame;
+        RenderWaveformColumns(rendererData, data, rect.x, rect.y, width, height,
+                              startFrame, framesPerPixel, available);
     }
     
     // Draw beat positions if available
+    WaveformGeometry *geometry = &rendererData->waveformGeometry;
     if (data->beat_positions && data->beat_count > 0) {
-        // Set beat marker color (use beatColor if set, otherwise use a default bright color)
+        // Use beatColor if set, otherwise default to a bright yellow
+        SDL_Color beatColor = {255, 255, 0, 255};
         if (data->beatColor.a > 0) {
-            SDL_SetRenderDrawColor(rendererData->renderer, 
-                                  data->beatColor.r, 
-                                  data->beatColor.g, 
-                                  data->beatColor.b, 
-                                  data->beatColor.a);
-        } else {
-            // Default to a bright yellow if beatColor not set
-            SDL_SetRenderDrawColor(rendererData->renderer, 255, 255, 0, 255);
+            beatColor = (SDL_Color){data->beatColor.r, data->beatColor.g,
+                                    data->beatColor.b, data->beatColor.a};
         }
         
-        // Draw a vertical line for each beat position
-        for (int i = 0; i < data->beat_count; i++) {
-            unsigned int beatPos = data->beat_positions[i];
-            
-            // Check if this beat is within the visible range
-            if (beatPos >= startSample && beatPos < startSample + visibleSamples) {
+        const Sint64 *beats = data->beat_positions;
+        const int firstBeat = beat_index_lower_bound(beats, data->beat_count, startFrame);
+        const int endBeat = beat_index_lower_bound(beats, data->beat_count, endFrame);
+        const int visibleBeats = endBeat - firstBeat;
+
+        int markerCount = 0;
+        if (visibleBeats > 0 && visibleBeats * BEAT_MIN_SPACING_PX > width) {
+            // Beats are closer than a few pixels: individual lines would pile
+            // up at the same x. Mark each run of columns that holds beats as
+            // one translucent band instead, found column by column so the
+            // cost stays O(width log beats) however many beats are visible.
+            const bool reserved = ReserveWaveformMarkers(geometry, (width + 1) / 2);
+            int bandStart = -1;
+            int beat = firstBeat;
+            for (int x = 0; reserved && x <= width; x++) {
+                bool occupied = false;
+                if (x < width && beat < endBeat) {
+                    Sint64 columnEnd = startFrame + (Sint64)((x + 1) * framesPerPixel);
+                    int next = beat_index_lower_bound(beats + beat, endBeat - beat, columnEnd) + beat;
+                    occupied = next > beat;
+                    beat = next;
+                }
+                if (occupied && bandStart < 0) {
+                    bandStart = x;
+                } else if (!occupied && bandStart >= 0) {
+                    geometry->markers[markerCount++] =
+                        (SDL_FRect){rect.x + bandStart, rect.y, x - bandStart, height};
+                    bandStart = -1;
+                }
+            }
+
+            SDL_SetRenderDrawBlendMode(rendererData->renderer, SDL_BLENDMODE_BLEND);
+            SDL_SetRenderDrawColor(rendererData->renderer,
+                                   beatColor.r, beatColor.g, beatColor.b, beatColor.a / 2);
+        } else if (visibleBeats > 0 && ReserveWaveformMarkers(geometry, visibleBeats)) {
+            // Collect one 1px rect per visible beat and draw them in one call
+            SDL_SetRenderDrawColor(rendererData->renderer,
+                                   beatColor.r, beatColor.g, beatColor.b, beatColor.a);
+            for (int i = firstBeat; i < endBeat; i++) {
                 // Calculate x position for this beat
-                float relativePos = (float)(beatPos - startSample) / visibleSamples;
-                int x = rect.x + (relativePos * width);
-                
-                // Draw a vertical line for the beat
-                SDL_RenderLine(rendererData->renderer, 
-                              x, rect.y, 
-                              x, rect.y + height);
+                int x = rect.x + (int)((beats[i] - startFrame) / framesPerPixel);
+                geometry->markers[markerCount++] = (SDL_FRect){x, rect.y, 1, height};
             }
         }
+        if (markerCount > 0) {
+            SDL_RenderFillRects(rendererData->renderer, geometry->markers, markerCount);
+            rendererData->stats.drawCalls++;
+        }
     }
     
     // Draw selection
@@ -124,21 +441,21 @@ void DrawWaveform(Clay_SDL3RendererData *rendererData, SDL_FRect rect, WaveformD
         float start_x, end_x;
 
         // Calculate screen x for selection start, clamped to view
-        if (data->selection_start <= startSample) {
+        if (data->selection_start <= startFrame) {
             start_x = rect.x;
-        } else if (data->selection_start >= startSample + visibleSamples) {
+        } else if (data->selection_start >= endFrame) {
             start_x = rect.x + width;
         } else {
-            start_x = rect.x + ((float)(data->selection_start - startSample) / visibleSamples) * width;
+            start_x = rect.x + (float)((data->selection_start - startFrame) / framesPerPixel);
         }
 
         // Calculate screen x for selection end, clamped to view
-        if (data->selection_end <= startSample) {
+        if (data->selection_end <= startFrame) {
             end_x = rect.x;
-        } else if (data->selection_end >= startSample + visibleSamples) {
+        } else if (data->selection_end >= endFrame) {
             end_x = rect.x + width;
         } else {
-            end_x = rect.x + ((float)(data->selection_end - startSample) / visibleSamples) * width;
+            end_x = rect.x + (float)((data->selection_end - startFrame) / framesPerPixel);
         }
 
         SDL_SetRenderDrawBlendMode(rendererData->renderer, SDL_BLENDMODE_BLEND);
@@ -147,35 +464,39 @@ void DrawWaveform(Clay_SDL3RendererData *rendererData, SDL_FRect rect, WaveformD
         if (start_x > rect.x) {
             SDL_FRect pre_selection_rect = {rect.x, rect.y, start_x - rect.x, height};
             SDL_RenderFillRect(rendererData->renderer, &pre_selection_rect);
+            rendererData->stats.drawCalls++;
         }
 
         if (end_x < rect.x + width) {
             SDL_FRect post_selection_rect = {end_x, rect.y, (rect.x + width) - end_x, height};
             SDL_RenderFillRect(rendererData->renderer, &post_selection_rect);
+            rendererData->stats.drawCalls++;
         }
 
         // Draw selection handles
-        if (data->selection_start > 0 && data->selection_start >= startSample && data->selection_start < startSample + visibleSamples) {
+        if (data->selection_start > 0 && data->selection_start >= startFrame && data->selection_start < endFrame) {
             if (data->is_hovering_selection_start) {
                 SDL_SetRenderDrawColor(rendererData->renderer, 100, 100, 255, 255);
             } else {
                 SDL_SetRenderDrawColor(rendererData->renderer, 0, 160, 255, 255);
             }
             SDL_RenderLine(rendererData->renderer, start_x, rect.y, start_x, rect.y + height);
+            rendererData->stats.drawCalls++;
         }
-        if (data->selection_end < (unsigned int)data->sampleCount && data->selection_end > startSample && data->selection_end <= startSample + visibleSamples) {
+        if (data->selection_end < data->frameCount && data->selection_end > startFrame && data->selection_end <= endFrame) {
             if (data->is_hovering_selection_end) {
                 SDL_SetRenderDrawColor(rendererData->renderer, 100, 100, 255, 255);
             } else {
                 SDL_SetRenderDrawColor(rendererData->renderer, 0, 160, 255, 255);
             }
             SDL_RenderLine(rendererData->renderer, end_x, rect.y, end_x, rect.y + height);
+            rendererData->stats.drawCalls++;
         }
     }
 
     // Draw playback cursor if enabled and visible
-    if (data->showPlaybackCursor && data->playbackPosition >= startSample && 
-        data->playbackPosition < startSample + visibleSamples) {
+    if (data->showPlaybackCursor && data->playbackPosition >= startFrame && 
+        data->playbackPosition < endFrame) {
         
         // Set cursor color (use cursorColor if set, otherwise use a default bright color)
         if (data->cursorColor.a > 0) {
@@ -190,183 +511,267 @@ void DrawWaveform(Clay_SDL3RendererData *rendererData, SDL_FRect rect, WaveformD
         }
         
         // Calculate x position for the playback cursor
-        float relativePos = (float)(data->playbackPosition - startSample) / visibleSamples;
-        int x = rect.x + (relativePos * width);
+        int x = rect.x + (int)((data->playbackPosition - startFrame) / framesPerPixel);
         
-        // Draw a thicker vertical line for the playback cursor
-        SDL_RenderLine(rendererData->renderer, x, rect.y, x, rect.y + height);
-        SDL_RenderLine(rendererData->renderer, x + 1, rect.y, x + 1, rect.y + height);
+        // Draw a 2px wide vertical bar for the playback cursor
+        SDL_FRect cursorRect = {x, rect.y, 2, height};
+        SDL_RenderFillRect(rendererData->renderer, &cursorRect);
+        rendererData->stats.drawCalls++;
     }
 }
 
-/* Global for convenience. Even in 4K this is enough for smooth curves (low radius or rect size coupled with
+/* Minimum segments per quarter circle. Even in 4K this is enough for smooth curves (low radius or rect size coupled with
  * no AA or low resolution might make it appear as jagged curves) */
-static int NUM_CIRCLE_SEGMENTS = 16;
-
-//all rendering is performed by a single SDL call, avoiding multiple RenderRect + plumbing choice for circles.
-static void SDL_Clay_RenderFillRoundedRect(Clay_SDL3RendererData *rendererData, const SDL_FRect rect, const float cornerRadius, const Clay_Color _color) {
-    const SDL_FColor color = { _color.r/255, _color.g/255, _color.b/255, _color.a/255 };
-
-    int indexCount = 0, vertexCount = 0;
-
-    const float minRadius = SDL_min(rect.w, rect.h) / 2.0f;
-    const float clampedRadius = SDL_min(cornerRadius, minRadius);
+#define MIN_CORNER_SEGMENTS 16
+#define MAX_CORNER_SEGMENTS 64
+
+// cos/sin of MAX_CORNER_SEGMENTS + 1 evenly spaced angles over [0, pi/2].
+// Coarser corners step through it with a stride.
+static SDL_FPoint cornerTable[MAX_CORNER_SEGMENTS + 1];
+static bool cornerTableReady = false;
+
+static void InitCornerTable(void) {
+    if (cornerTableReady) return;
+    const float step = (SDL_PI_F / 2) / MAX_CORNER_SEGMENTS;
+    for (int i = 0; i <= MAX_CORNER_SEGMENTS; i++) {
+        cornerTable[i] = (SDL_FPoint){ SDL_cosf(i * step), SDL_sinf(i * step) };
+    }
+    cornerTableReady = true;
+}
 
-    const int numCircleSegments = SDL_max(NUM_CIRCLE_SEGMENTS, (int) clampedRadius * 0.5f);
+// Segments for a corner wanting at least `wanted`: a divisor of the table size
+static int CornerSegments(float wanted) {
+    int segments = MIN_CORNER_SEGMENTS;
+    while (segments < wanted && segments < MAX_CORNER_SEGMENTS) {
+        segments *= 2;
+    }
+    return segments;
+}
 
-    int totalVertices = 4 + (4 * (numCircleSegments * 2)) + 2*4;
-    int totalIndices = 6 + (4 * (numCircleSegments * 3)) + 6*4;
+// Quadrant signs for the four corners: top-left, top-right, bottom-right, bottom-left
+static const float cornerSignX[4] = { -1, 1, 1, -1 };
+static const float cornerSignY[4] = { -1, -1, 1, 1 };
+
+static bool ReserveShapes(ShapeBatch *batch, int vertices, int indices) {
+    if (batch->vertexCount + vertices > batch->vertexCapacity) {
+        int capacity = SDL_max(batch->vertexCapacity * 2, batch->vertexCount + vertices);
+        SDL_Vertex *grown = SDL_realloc(batch->vertices, (size_t)capacity * sizeof(SDL_Vertex));
+        if (!grown) return false;
+        batch->vertices = grown;
+        batch->vertexCapacity = capacity;
+    }
+    if (batch->indexCount + indices > batch->indexCapacity) {
+        int capacity = SDL_max(batch->indexCapacity * 2, batch->indexCount + indices);
+        int *grown = SDL_realloc(batch->indices, (size_t)capacity * sizeof(int));
+        if (!grown) return false;
+        batch->indices = grown;
+        batch->indexCapacity = capacity;
+    }
+    return true;
+}
 
-    SDL_Vertex *vertices = (SDL_Vertex *)SDL_malloc(totalVertices * sizeof(SDL_Vertex));
-    if (!vertices) return;
-    int *indices = (int *)SDL_malloc(totalIndices * sizeof(int));
-    if (!indices) {
-        SDL_free(vertices);
+// Set the clip Clay asked for on the renderer, if it isn't already
+static void ApplyClip(Clay_SDL3RendererData *rendererData) {
+    const RenderClip *clip = &rendererData->clip;
+    RenderClip *applied = &rendererData->appliedClip;
+    if (clip->enabled == applied->enabled &&
+        (!clip->enabled || SDL_RectsEqual(&clip->rect, &applied->rect))) {
         return;
     }
+    SDL_SetRenderClipRect(rendererData->renderer, clip->enabled ? &clip->rect : NULL);
+    *applied = *clip;
+    rendererData->stats.clipChanges++;
+}
 
-    //define center rectangle
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + clampedRadius, rect.y + clampedRadius}, color, {0, 0} }; //0 center TL
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + rect.w - clampedRadius, rect.y + clampedRadius}, color, {1, 0} }; //1 center TR
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + rect.w - clampedRadius, rect.y + rect.h - clampedRadius}, color, {1, 1} }; //2 center BR
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + clampedRadius, rect.y + rect.h - clampedRadius}, color, {0, 1} }; //3 center BL
-
-    indices[indexCount++] = 0;
-    indices[indexCount++] = 1;
-    indices[indexCount++] = 3;
-    indices[indexCount++] = 1;
-    indices[indexCount++] = 2;
-    indices[indexCount++] = 3;
-
-    //define rounded corners as triangle fans
-    const float step = (SDL_PI_F/2) / numCircleSegments;
-    for (int i = 0; i < numCircleSegments; i++) {
-        const float angle1 = (float)i * step;
-        const float angle2 = ((float)i + 1.0f) * step;
-
-        for (int j = 0; j < 4; j++) {  // Iterate over four corners
-            float cx, cy, signX, signY;
-
-            switch (j) {
-                case 0: cx = rect.x + clampedRadius; cy = rect.y + clampedRadius; signX = -1; signY = -1; break; // Top-left
-                case 1: cx = rect.x + rect.w - clampedRadius; cy = rect.y + clampedRadius; signX = 1; signY = -1; break; // Top-right
-                case 2: cx = rect.x + rect.w - clampedRadius; cy = rect.y + rect.h - clampedRadius; signX = 1; signY = 1; break; // Bottom-right
-                case 3: cx = rect.x + clampedRadius; cy = rect.y + rect.h - clampedRadius; signX = -1; signY = 1; break; // Bottom-left
-                default: return;
-            }
-
-            vertices[vertexCount++] = (SDL_Vertex){ {cx + SDL_cosf(angle1) * clampedRadius * signX, cy + SDL_sinf(angle1) * clampedRadius * signY}, color, {0, 0} };
-            vertices[vertexCount++] = (SDL_Vertex){ {cx + SDL_cosf(angle2) * clampedRadius * signX, cy + SDL_sinf(angle2) * clampedRadius * signY}, color, {0, 0} };
+// Draw the shapes queued so far and start an empty batch. Called before
+// anything that isn't part of the batch is drawn, so painter's order holds.
+static void FlushShapes(Clay_SDL3RendererData *rendererData) {
+    ShapeBatch *batch = &rendererData->shapes;
+    if (batch->indexCount > 0) {
+        ApplyClip(rendererData);
+        SDL_SetRenderDrawBlendMode(rendererData->renderer, SDL_BLENDMODE_BLEND);
+        SDL_RenderGeometry(rendererData->renderer, batch->texture, batch->vertices, batch->vertexCount,
+                           batch->indices, batch->indexCount);
+        rendererData->stats.drawCalls++;
+        rendererData->stats.batches++;
+    }
+    batch->vertexCount = 0;
+    batch->indexCount = 0;
+}
 
-            indices[indexCount++] = j;  // Connect to corresponding central rectangle vertex
-            indices[indexCount++] = vertexCount - 2;
-            indices[indexCount++] = vertexCount - 1;
-        }
+// Start queueing triangles that sample `texture` (NULL for solid colour),
+// submitting the queued ones first if they use another texture
+static ShapeBatch* BeginShapes(Clay_SDL3RendererData *rendererData, SDL_Texture *texture) {
+    ShapeBatch *batch = &rendererData->shapes;
+    if (batch->texture != texture) {
+        FlushShapes(rendererData);
+        batch->texture = texture;
     }
+    return batch;
+}
 
-    //Define edge rectangles
-    // Top edge
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + clampedRadius, rect.y}, color, {0, 0} }; //TL
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + rect.w - clampedRadius, rect.y}, color, {1, 0} }; //TR
-
-    indices[indexCount++] = 0;
-    indices[indexCount++] = vertexCount - 2; //TL
-    indices[indexCount++] = vertexCount - 1; //TR
-    indices[indexCount++] = 1;
-    indices[indexCount++] = 0;
-    indices[indexCount++] = vertexCount - 1; //TR
-    // Right edge
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + rect.w, rect.y + clampedRadius}, color, {1, 0} }; //RT
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + rect.w, rect.y + rect.h - clampedRadius}, color, {1, 1} }; //RB
-
-    indices[indexCount++] = 1;
-    indices[indexCount++] = vertexCount - 2; //RT
-    indices[indexCount++] = vertexCount - 1; //RB
-    indices[indexCount++] = 2;
-    indices[indexCount++] = 1;
-    indices[indexCount++] = vertexCount - 1; //RB
-    // Bottom edge
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + rect.w - clampedRadius, rect.y + rect.h}, color, {1, 1} }; //BR
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x + clampedRadius, rect.y + rect.h}, color, {0, 1} }; //BL
-
-    indices[indexCount++] = 2;
-    indices[indexCount++] = vertexCount - 2; //BR
-    indices[indexCount++] = vertexCount - 1; //BL
-    indices[indexCount++] = 3;
-    indices[indexCount++] = 2;
-    indices[indexCount++] = vertexCount - 1; //BL
-    // Left edge
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x, rect.y + rect.h - clampedRadius}, color, {0, 1} }; //LB
-    vertices[vertexCount++] = (SDL_Vertex){ {rect.x, rect.y + clampedRadius}, color, {0, 0} }; //LT
-
-    indices[indexCount++] = 3;
-    indices[indexCount++] = vertexCount - 2; //LB
-    indices[indexCount++] = vertexCount - 1; //LT
-    indices[indexCount++] = 0;
-    indices[indexCount++] = 3;
-    indices[indexCount++] = vertexCount - 1; //LT
-
-    // Render everything
-    SDL_RenderGeometry(rendererData->renderer, NULL, vertices, vertexCount, indices, indexCount);
-
-    SDL_free(vertices);
-    SDL_free(indices);
+// Clip the following commands. Shapes queued under the previous clip are
+// submitted first; the renderer itself is only updated by the next draw.
+static void SetClip(Clay_SDL3RendererData *rendererData, const RenderClip clip) {
+    const RenderClip *current = &rendererData->clip;
+    if (clip.enabled == current->enabled &&
+        (!clip.enabled || SDL_RectsEqual(&clip.rect, &current->rect))) {
+        return;
+    }
+    FlushShapes(rendererData);
+    rendererData->clip = clip;
 }
 
-static void SDL_Clay_RenderArc(Clay_SDL3RendererData *rendererData, const SDL_FPoint center, const float radius, const float startAngle, const float endAngle, const float thickness, const Clay_Color color) {
-    SDL_SetRenderDrawColor(rendererData->renderer, color.r, color.g, color.b, color.a);
+void FreeShapeBatch(ShapeBatch *batch) {
+    SDL_free(batch->vertices);
+    SDL_free(batch->indices);
+    SDL_zerop(batch);
+}
 
-    const float radStart = startAngle * (SDL_PI_F / 180.0f);
-    const float radEnd = endAngle * (SDL_PI_F / 180.0f);
+// Queue a quad sampling `uv` (normalised) of the batch texture
+static void AddTexturedQuad(ShapeBatch *batch, const SDL_FRect rect, const SDL_FRect uv, const SDL_FColor color) {
+    if (rect.w <= 0 || rect.h <= 0 || !ReserveShapes(batch, 4, 6)) return;
+
+    const int base = batch->vertexCount;
+    SDL_Vertex *v = &batch->vertices[base];
+    v[0] = (SDL_Vertex){ {rect.x, rect.y}, color, {uv.x, uv.y} };
+    v[1] = (SDL_Vertex){ {rect.x + rect.w, rect.y}, color, {uv.x + uv.w, uv.y} };
+    v[2] = (SDL_Vertex){ {rect.x + rect.w, rect.y + rect.h}, color, {uv.x + uv.w, uv.y + uv.h} };
+    v[3] = (SDL_Vertex){ {rect.x, rect.y + rect.h}, color, {uv.x, uv.y + uv.h} };
+    batch->vertexCount += 4;
+
+    int *i = &batch->indices[batch->indexCount];
+    i[0] = base; i[1] = base + 1; i[2] = base + 3;
+    i[3] = base + 1; i[4] = base + 2; i[5] = base + 3;
+    batch->indexCount += 6;
+}
 
-    const int numCircleSegments = SDL_max(NUM_CIRCLE_SEGMENTS, (int)(radius * 1.5f)); //increase circle segments for larger circles, 1.5 is arbitrary.
+static void AddShapeQuad(ShapeBatch *batch, const SDL_FRect rect, const SDL_FColor color) {
+    AddTexturedQuad(batch, rect, (SDL_FRect){ 0, 0, 1, 1 }, color);
+}
 
-    const float angleStep = (radEnd - radStart) / (float)numCircleSegments;
-    const float thicknessStep = 0.4f; //arbitrary value to avoid overlapping lines. Changing THICKNESS_STEP or numCircleSegments might cause artifacts.
+static SDL_FColor ToFColor(const Clay_Color color) {
+    return (SDL_FColor){ color.r/255, color.g/255, color.b/255, color.a/255 };
+}
 
-    for (float t = thicknessStep; t < thickness - thicknessStep; t += thicknessStep) {
-        SDL_FPoint *points = (SDL_FPoint *)SDL_malloc((numCircleSegments + 1) * sizeof(SDL_FPoint));
-        if (!points) continue;
-        const float clampedRadius = SDL_max(radius - t, 1.0f);
+// Queue a filled rectangle with rounded corners: a center rectangle, four
+// edge rectangles and a triangle fan per corner
+static void SDL_Clay_RenderFillRoundedRect(Clay_SDL3RendererData *rendererData, const SDL_FRect rect, const float cornerRadius, const Clay_Color _color) {
+    ShapeBatch *batch = BeginShapes(rendererData, NULL);
+    const SDL_FColor color = ToFColor(_color);
 
-        for (int i = 0; i <= numCircleSegments; i++) {
-            const float angle = radStart + i * angleStep;
-            points[i] = (SDL_FPoint){
-                    SDL_roundf(center.x + SDL_cosf(angle) * clampedRadius),
-                    SDL_roundf(center.y + SDL_sinf(angle) * clampedRadius) };
+    const float minRadius = SDL_min(rect.w, rect.h) / 2.0f;
+    const float r = SDL_min(cornerRadius, minRadius);
+
+    const int segments = CornerSegments(r * 0.5f);
+    const int stride = MAX_CORNER_SEGMENTS / segments;
+
+    const SDL_FRect inner = { rect.x + r, rect.y + r, rect.w - 2 * r, rect.h - 2 * r };
+    AddShapeQuad(batch, inner, color);
+    AddShapeQuad(batch, (SDL_FRect){ inner.x, rect.y, inner.w, r }, color);                 // Top edge
+    AddShapeQuad(batch, (SDL_FRect){ inner.x + inner.w, inner.y, r, inner.h }, color);      // Right edge
+    AddShapeQuad(batch, (SDL_FRect){ inner.x, inner.y + inner.h, inner.w, r }, color);      // Bottom edge
+    AddShapeQuad(batch, (SDL_FRect){ rect.x, inner.y, r, inner.h }, color);                 // Left edge
+
+    if (r <= 0 || !ReserveShapes(batch, 4 * (segments + 2), 4 * segments * 3)) return;
+
+    InitCornerTable();
+    const float centerX[4] = { inner.x, inner.x + inner.w, inner.x + inner.w, inner.x };
+    const float centerY[4] = { inner.y, inner.y, inner.y + inner.h, inner.y + inner.h };
+    for (int j = 0; j < 4; j++) {
+        const int center = batch->vertexCount;
+        batch->vertices[batch->vertexCount++] = (SDL_Vertex){ {centerX[j], centerY[j]}, color, {0, 0} };
+        for (int k = 0; k <= segments; k++) {
+            const SDL_FPoint unit = cornerTable[k * stride];
+            batch->vertices[batch->vertexCount++] = (SDL_Vertex){
+                {centerX[j] + unit.x * r * cornerSignX[j], centerY[j] + unit.y * r * cornerSignY[j]},
+                color, {0, 0} };
+        }
+        for (int k = 0; k < segments; k++) {
+            batch->indices[batch->indexCount++] = center;
+            batch->indices[batch->indexCount++] = center + 1 + k;
+            batch->indices[batch->indexCount++] = center + 2 + k;
         }
-        SDL_RenderLines(rendererData->renderer, points, numCircleSegments + 1);
-        SDL_free(points);
     }
 }
 
-SDL_Rect currentClippingRectangle;
+// Queue a quarter ring for corner `corner` (0 = top-left, clockwise)
+static void SDL_Clay_RenderArc(Clay_SDL3RendererData *rendererData, const SDL_FPoint center, const float radius, const int corner, const float thickness, const Clay_Color _color) {
+    ShapeBatch *batch = BeginShapes(rendererData, NULL);
+    if (radius <= 0 || thickness <= 0) return;
+
+    const SDL_FColor color = ToFColor(_color);
+    const float innerRadius = SDL_max(radius - thickness, 0.0f);
+    const int segments = CornerSegments(radius * 1.5f); //increase circle segments for larger circles, 1.5 is arbitrary.
+    const int stride = MAX_CORNER_SEGMENTS / segments;
+    if (!ReserveShapes(batch, 2 * (segments + 1), segments * 6)) return;
+
+    InitCornerTable();
+    const int base = batch->vertexCount;
+    for (int k = 0; k <= segments; k++) {
+        const SDL_FPoint unit = cornerTable[k * stride];
+        const float dx = unit.x * cornerSignX[corner];
+        const float dy = unit.y * cornerSignY[corner];
+        batch->vertices[batch->vertexCount++] = (SDL_Vertex){
+            {center.x + dx * radius, center.y + dy * radius}, color, {0, 0} };
+        batch->vertices[batch->vertexCount++] = (SDL_Vertex){
+            {center.x + dx * innerRadius, center.y + dy * innerRadius}, color, {0, 0} };
+    }
+    for (int k = 0; k < segments; k++) {
+        const int outer = base + 2 * k;
+        batch->indices[batch->indexCount++] = outer;
+        batch->indices[batch->indexCount++] = outer + 2;
+        batch->indices[batch->indexCount++] = outer + 1;
+        batch->indices[batch->indexCount++] = outer + 1;
+        batch->indices[batch->indexCount++] = outer + 2;
+        batch->indices[batch->indexCount++] = outer + 3;
+    }
+}
 
 void SDL_Clay_RenderClayCommands(Clay_SDL3RendererData *rendererData, Clay_RenderCommandArray *rcommands)
 {
+    // The renderer starts every frame unclipped; see the end of this function
+    rendererData->stats = (RenderStats){ .commands = rcommands->length };
+    rendererData->clip = (RenderClip){ 0 };
+    rendererData->appliedClip = (RenderClip){ 0 };
+
     for (int32_t i = 0; i < rcommands->length; i++) {
         Clay_RenderCommand *rcmd = Clay_RenderCommandArray_Get(rcommands, i);
         const Clay_BoundingBox bounding_box = rcmd->boundingBox;
         const SDL_FRect rect = { (int)bounding_box.x, (int)bounding_box.y, (int)bounding_box.width, (int)bounding_box.height };
+        const Uint64 started = rendererData->timeCommands ? SDL_GetPerformanceCounter() : 0;
 
         switch (rcmd->commandType) {
             case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
                 Clay_RectangleRenderData *config = &rcmd->renderData.rectangle;
-                SDL_SetRenderDrawBlendMode(rendererData->renderer, SDL_BLENDMODE_BLEND);
-                SDL_SetRenderDrawColor(rendererData->renderer, config->backgroundColor.r, config->backgroundColor.g, config->backgroundColor.b, config->backgroundColor.a);
                 if (config->cornerRadius.topLeft > 0) {
                     SDL_Clay_RenderFillRoundedRect(rendererData, rect, config->cornerRadius.topLeft, config->backgroundColor);
                 } else {
-                    SDL_RenderFillRect(rendererData->renderer, &rect);
+                    AddShapeQuad(BeginShapes(rendererData, NULL), rect, ToFColor(config->backgroundColor));
                 }
             } break;
             case CLAY_RENDER_COMMAND_TYPE_TEXT: {
                 Clay_TextRenderData *config = &rcmd->renderData.text;
                 TTF_Font *font = rendererData->fonts[config->fontId];
-                TTF_Text *text = TTF_CreateText(rendererData->textEngine, font, config->stringContents.chars, config->stringContents.length);
-                TTF_SetTextColor(text, config->textColor.r, config->textColor.g, config->textColor.b, config->textColor.a);
-                TTF_DrawRendererText(text, rect.x, rect.y);
-                TTF_DestroyText(text);
+                const SDL_Color color = {config->textColor.r, config->textColor.g,
+                                         config->textColor.b, config->textColor.a};
+                // The text engine draws glyphs from its own atlas and doesn't
+                // hand out the geometry, so text ends the current batch
+                FlushShapes(rendererData);
+                ApplyClip(rendererData);
+                rendererData->stats.drawCalls++;
+                TTF_Text *text = rendererData->textCache
+                    ? text_cache_get(rendererData->textCache, font, config->stringContents.chars,
+                                     config->stringContents.length, color)
+                    : NULL;
+                if (text) {
+                    TTF_DrawRendererText(text, rect.x, rect.y);
+                } else {
+                    text = TTF_CreateText(rendererData->textEngine, font, config->stringContents.chars, config->stringContents.length);
+                    TTF_SetTextColor(text, color.r, color.g, color.b, color.a);
+                    TTF_DrawRendererText(text, rect.x, rect.y);
+                    TTF_DestroyText(text);
+                }
             } break;
             case CLAY_RENDER_COMMAND_TYPE_BORDER: {
                 Clay_BorderRenderData *config = &rcmd->renderData.border;
@@ -379,83 +784,74 @@ void SDL_Clay_RenderClayCommands(Clay_SDL3RendererData *rendererData, Clay_Rende
                     .bottomRight = SDL_min(config->cornerRadius.bottomRight, minRadius)
                 };
                 //edges
-                SDL_SetRenderDrawColor(rendererData->renderer, config->color.r, config->color.g, config->color.b, config->color.a);
+                ShapeBatch *batch = BeginShapes(rendererData, NULL);
+                const SDL_FColor color = ToFColor(config->color);
                 if (config->width.left > 0) {
                     const float starting_y = rect.y + clampedRadii.topLeft;
                     const float length = rect.h - clampedRadii.topLeft - clampedRadii.bottomLeft;
-                    SDL_FRect line = { rect.x, starting_y, config->width.left, length };
-                    SDL_RenderFillRect(rendererData->renderer, &line);
+                    AddShapeQuad(batch, (SDL_FRect){ rect.x, starting_y, config->width.left, length }, color);
                 }
                 if (config->width.right > 0) {
                     const float starting_x = rect.x + rect.w - (float)config->width.right;
                     const float starting_y = rect.y + clampedRadii.topRight;
                     const float length = rect.h - clampedRadii.topRight - clampedRadii.bottomRight;
-                    SDL_FRect line = { starting_x, starting_y, config->width.right, length };
-                    SDL_RenderFillRect(rendererData->renderer, &line);
+                    AddShapeQuad(batch, (SDL_FRect){ starting_x, starting_y, config->width.right, length }, color);
                 }
                 if (config->width.top > 0) {
                     const float starting_x = rect.x + clampedRadii.topLeft;
                     const float length = rect.w - clampedRadii.topLeft - clampedRadii.topRight;
-                    SDL_FRect line = { starting_x, rect.y, length, config->width.top };
-                    SDL_RenderFillRect(rendererData->renderer, &line);
+                    AddShapeQuad(batch, (SDL_FRect){ starting_x, rect.y, length, config->width.top }, color);
                 }
                 if (config->width.bottom > 0) {
                     const float starting_x = rect.x + clampedRadii.bottomLeft;
                     const float starting_y = rect.y + rect.h - (float)config->width.bottom;
                     const float length = rect.w - clampedRadii.bottomLeft - clampedRadii.bottomRight;
-                    SDL_FRect line = { starting_x, starting_y, length, config->width.bottom };
-                    SDL_SetRenderDrawColor(rendererData->renderer, config->color.r, config->color.g, config->color.b, config->color.a);
-                    SDL_RenderFillRect(rendererData->renderer, &line);
+                    AddShapeQuad(batch, (SDL_FRect){ starting_x, starting_y, length, config->width.bottom }, color);
                 }
-                //corners
+                //corners, as rings joining the edges
                 if (config->cornerRadius.topLeft > 0) {
-                    const float centerX = rect.x + clampedRadii.topLeft -1;
-                    const float centerY = rect.y + clampedRadii.topLeft;
-                    SDL_Clay_RenderArc(rendererData, (SDL_FPoint){centerX, centerY}, clampedRadii.topLeft,
-                        180.0f, 270.0f, config->width.top, config->color);
+                    const SDL_FPoint center = { rect.x + clampedRadii.topLeft, rect.y + clampedRadii.topLeft };
+                    SDL_Clay_RenderArc(rendererData, center, clampedRadii.topLeft, 0, config->width.top, config->color);
                 }
                 if (config->cornerRadius.topRight > 0) {
-                    const float centerX = rect.x + rect.w - clampedRadii.topRight -1;
-                    const float centerY = rect.y + clampedRadii.topRight;
-                    SDL_Clay_RenderArc(rendererData, (SDL_FPoint){centerX, centerY}, clampedRadii.topRight,
-                        270.0f, 360.0f, config->width.top, config->color);
-                }
-                if (config->cornerRadius.bottomLeft > 0) {
-                    const float centerX = rect.x + clampedRadii.bottomLeft -1;
-                    const float centerY = rect.y + rect.h - clampedRadii.bottomLeft -1;
-                    SDL_Clay_RenderArc(rendererData, (SDL_FPoint){centerX, centerY}, clampedRadii.bottomLeft,
-                        90.0f, 180.0f, config->width.bottom, config->color);
+                    const SDL_FPoint center = { rect.x + rect.w - clampedRadii.topRight, rect.y + clampedRadii.topRight };
+                    SDL_Clay_RenderArc(rendererData, center, clampedRadii.topRight, 1, config->width.top, config->color);
                 }
                 if (config->cornerRadius.bottomRight > 0) {
-                    const float centerX = rect.x + rect.w - clampedRadii.bottomRight -1; //TODO: why need to -1 in all calculations???
-                    const float centerY = rect.y + rect.h - clampedRadii.bottomRight -1;
-                    SDL_Clay_RenderArc(rendererData, (SDL_FPoint){centerX, centerY}, clampedRadii.bottomRight,
-                        0.0f, 90.0f, config->width.bottom, config->color);
+                    const SDL_FPoint center = { rect.x + rect.w - clampedRadii.bottomRight, rect.y + rect.h - clampedRadii.bottomRight };
+                    SDL_Clay_RenderArc(rendererData, center, clampedRadii.bottomRight, 2, config->width.bottom, config->color);
+                }
+                if (config->cornerRadius.bottomLeft > 0) {
+                    const SDL_FPoint center = { rect.x + clampedRadii.bottomLeft, rect.y + rect.h - clampedRadii.bottomLeft };
+                    SDL_Clay_RenderArc(rendererData, center, clampedRadii.bottomLeft, 3, config->width.bottom, config->color);
                 }
 
             } break;
             case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
                 Clay_BoundingBox boundingBox = rcmd->boundingBox;
-                currentClippingRectangle = (SDL_Rect) {
+                SetClip(rendererData, (RenderClip){ true, {
                         .x = boundingBox.x,
                         .y = boundingBox.y,
                         .w = boundingBox.width,
                         .h = boundingBox.height,
-                };
-                SDL_SetRenderClipRect(rendererData->renderer, &currentClippingRectangle);
+                } });
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
-                SDL_SetRenderClipRect(rendererData->renderer, NULL);
+                SetClip(rendererData, (RenderClip){ 0 });
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
-                SDL_Surface *image = (SDL_Surface *)rcmd->renderData.image.imageData;
-                SDL_Texture *texture = SDL_CreateTextureFromSurface(rendererData->renderer, image);
-                const SDL_FRect dest = { rect.x, rect.y, rect.w, rect.h };
-
-                SDL_RenderTexture(rendererData->renderer, texture, NULL, &dest);
-                SDL_DestroyTexture(texture);
+                const AtlasImage *image = (const AtlasImage *)rcmd->renderData.image.imageData;
+                float textureW, textureH;
+                if (!image || !image->texture || !SDL_GetTextureSize(image->texture, &textureW, &textureH)) {
+                    break;
+                }
+                // Icons share one atlas texture, so a row of them is one batch
+                const SDL_FRect uv = { image->source.x / textureW, image->source.y / textureH,
+                                       image->source.w / textureW, image->source.h / textureH };
+                AddTexturedQuad(BeginShapes(rendererData, image->texture), rect, uv,
+                                (SDL_FColor){ 1, 1, 1, 1 });
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
@@ -464,13 +860,32 @@ void SDL_Clay_RenderClayCommands(Clay_SDL3RendererData *rendererData, Clay_Rende
                 // Check if this is a waveform
                 WaveformData *waveformData = (WaveformData*)config->customData;
                 if (waveformData) {
+                    FlushShapes(rendererData);
+                    ApplyClip(rendererData);
                     // Draw the waveform
+                    const Uint64 waveformStarted = rendererData->timeCommands ? SDL_GetPerformanceCounter() : 0;
                     DrawWaveform(rendererData, rect, waveformData);
+                    if (rendererData->timeCommands) {
+                        rendererData->stats.waveformTicks += SDL_GetPerformanceCounter() - waveformStarted;
+                    }
                 }
                 break;
             }
             default:
                 SDL_Log("Unknown render command type: %d", rcmd->commandType);
         }
+
+        if (rendererData->timeCommands && rcmd->commandType <= CLAY_RENDER_COMMAND_TYPE_CUSTOM) {
+            rendererData->stats.commandTicks[rcmd->commandType] += SDL_GetPerformanceCounter() - started;
+        }
+    }
+    FlushShapes(rendererData);
+
+    // Hand the renderer back unclipped, for the overlay and the next frame
+    rendererData->clip = (RenderClip){ 0 };
+    ApplyClip(rendererData);
+
+    if (rendererData->textCache) {
+        text_cache_end_frame(rendererData->textCache);
     }
 }
@@ -5,12 +5,20 @@
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 #include <stdbool.h>
+#include "waveform_pyramid.h"
+#include "text_cache.h"
 
-// Waveform data structure
+// Waveform data structure. All positions are frame indices (one sample per
+// channel), 64-bit so multi-hour files fit.
 typedef struct {
-    float* samples;      // Audio samples
-    int sampleCount;     // Number of samples
-    unsigned int* beat_positions; // Beat positions (sample indices)
+    float* samples;      // Interleaved audio samples
+    int channels;        // Samples per frame
+    Sint64 frameCount;   // Number of frames on the timeline
+    Sint64 decodedFrames; // Frames available so far (< frameCount while decoding)
+    const WaveformPyramid* peaks; // Min/max/RMS summary of samples
+    Sint64 peakFrames;   // Frames the peaks cover ahead of the samples (cached files)
+    Uint32 sourceId;     // Changes whenever samples belong to a different file
+    const Sint64* beat_positions; // Beat positions (frame indices)
     int beat_count;      // Number of beats
     float currentZoom;   // Zoom level (1.0 = normal)
     float currentScroll; // Scroll position (0.0 = start)
@@ -19,26 +27,115 @@ typedef struct {
     
     // Playback cursor
     bool showPlaybackCursor;     // Whether to show playback cursor
-    unsigned int playbackPosition; // Current playback position in samples
+    Sint64 playbackPosition;     // Current playback position in frames
     Clay_Color cursorColor;      // Color of the playback cursor
 
     // Selection
-    unsigned int selection_start;
-    unsigned int selection_end;
+    Sint64 selection_start;
+    Sint64 selection_end;
     bool is_hovering_selection_start;
     bool is_hovering_selection_end;
 } WaveformData;
 
 
+// A sub-rectangle of a shared texture, passed to Clay as imageData
+typedef struct {
+    SDL_Texture *texture;
+    SDL_FRect source;
+} AtlasImage;
+
+// Scratch buffers kept across frames so DrawWaveform can submit the
+// waveform and the beat markers as one batch each without allocating
+typedef struct {
+    SDL_Vertex *vertices;   // 8 per column: peak quad and RMS quad
+    int *indices;           // 12 per column
+    int columnCapacity;
+    SDL_FRect *markers;     // One per visible beat
+    int markerCapacity;
+} WaveformGeometry;
+
+// Triangles from consecutive rectangles, borders and images that share a
+// texture and clip, submitted with one SDL_RenderGeometry call. The arrays
+// are reused every frame and only grow, so a steady frame doesn't allocate.
+typedef struct {
+    SDL_Texture *texture;   // NULL while the queued triangles are untextured
+    SDL_Vertex *vertices;
+    int *indices;
+    int vertexCount, indexCount;
+    int vertexCapacity, indexCapacity;
+} ShapeBatch;
+
+// Width in pixels of one cached waveform tile
+#define WAVEFORM_TILE_WIDTH 256
+
+// Tiles kept in VRAM; must exceed the tiles visible across the widest window
+#define WAVEFORM_TILE_CACHE_SIZE 48
+
+// A rasterised stretch of waveform. Each column covers 2^exponent frames,
+// so a tile is reused across every zoom that rounds up to the same exponent
+// and is stretched by less than 2x when drawn.
+typedef struct {
+    SDL_Texture *texture;
+    bool valid;
+    int exponent;
+    Sint64 index;            // Tile i starts at frame i * WAVEFORM_TILE_WIDTH * 2^exponent
+    Sint64 decodedFrames;    // Frames that were available when it was rasterised
+    Uint64 lastUsed;
+} WaveformTile;
+
+// LRU cache of waveform tiles, so a frame only rasterises tiles that just
+// scrolled into view or that the decoder has extended since
+typedef struct {
+    WaveformTile tiles[WAVEFORM_TILE_CACHE_SIZE];
+    Uint32 sourceId;
+    int height;
+    Uint64 clock;
+} WaveformTileCache;
+
+// Clip rectangle requested by Clay, or the one last set on the renderer
+typedef struct {
+    bool enabled;
+    SDL_Rect rect;
+} RenderClip;
+
+// Work submitted by the last SDL_Clay_RenderClayCommands call
+typedef struct {
+    int commands;      // Clay render commands processed
+    int drawCalls;     // SDL draw calls issued, DrawWaveform's included
+    int batches;       // Merged geometry submissions among drawCalls
+    int clipChanges;   // Clip rectangles actually set on the renderer
+
+    // Only filled while timeCommands is set, in SDL_GetPerformanceCounter ticks
+    Uint64 commandTicks[CLAY_RENDER_COMMAND_TYPE_CUSTOM + 1];   // Per Clay_RenderCommandType
+    Uint64 waveformTicks;                                       // DrawWaveform, also counted as CUSTOM
+} RenderStats;
+
 typedef struct {
     SDL_Renderer *renderer;
     TTF_TextEngine *textEngine;
     TTF_Font **fonts;
+    TextCache *textCache;   // Shaped text reused across frames, may be NULL
+    ShapeBatch shapes;
+    RenderClip clip;          // Applied lazily, right before the next draw
+    RenderClip appliedClip;
+    RenderStats stats;
+    bool timeCommands;        // Time every command into stats, for the performance overlay
+    WaveformGeometry waveformGeometry;
+    WaveformTileCache waveformTiles;
 } Clay_SDL3RendererData;
 
 // Function to draw a waveform
 void DrawWaveform(Clay_SDL3RendererData *rendererData, SDL_FRect rect, WaveformData *data);
 
+// Release the buffers DrawWaveform keeps between frames
+void FreeWaveformGeometry(WaveformGeometry *geometry);
+
+// Release the buffers rectangles and borders are batched into
+void FreeShapeBatch(ShapeBatch *batch);
+
+// Destroy the cached tile textures. Call before destroying the renderer.
+void FreeWaveformTiles(WaveformTileCache *cache);
+
 void SDL_Clay_RenderClayCommands(Clay_SDL3RendererData *rendererData, Clay_RenderCommandArray *rcommands);
 
 #endif // CLAY_RENDERER_SDL3_H
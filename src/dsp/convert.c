@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "convert_impl.h"
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    void (*s16_to_f32)(const Sint16 *in, float *out, size_t count);
+    void (*s32_to_f32)(const Sint32 *in, float *out, size_t count);
+    void (*downmix)(const float *in, float *out, size_t frames, int channels);
+    void (*peak)(const float *in, size_t count, float *out_min, float *out_max,
+                 float *out_sum_squares);
+} ConvertKernels;
+
+static ConvertKernels kernels = {
+    .name = "scalar",
+    .s16_to_f32 = convert_s16_to_f32_scalar,
+    .s32_to_f32 = convert_s32_to_f32_scalar,
+    .downmix = convert_downmix_f32_scalar,
+    .peak = convert_peak_f32_scalar,
+};
+
+void convert_init(void) {
+#ifdef AUTOMARKER_HAVE_SSE2
+    if (SDL_HasSSE2()) {
+        kernels.name = "sse2";
+        kernels.s16_to_f32 = convert_s16_to_f32_sse2;
+        kernels.s32_to_f32 = convert_s32_to_f32_sse2;
+        kernels.downmix = convert_downmix_f32_sse2;
+        kernels.peak = convert_peak_f32_sse2;
+    }
+#endif
+#ifdef AUTOMARKER_HAVE_AVX2
+    // AVX2 replaces every kernel that has a vector form
+    if (SDL_HasAVX2()) {
+        kernels.name = "avx2";
+        kernels.s16_to_f32 = convert_s16_to_f32_avx2;
+        kernels.s32_to_f32 = convert_s32_to_f32_avx2;
+        kernels.downmix = convert_downmix_f32_avx2;
+        kernels.peak = convert_peak_f32_avx2;
+    }
+#endif
+#ifdef AUTOMARKER_HAVE_NEON
+    if (SDL_HasNEON()) {
+        kernels.name = "neon";
+        kernels.s16_to_f32 = convert_s16_to_f32_neon;
+        kernels.s32_to_f32 = convert_s32_to_f32_neon;
+        kernels.downmix = convert_downmix_f32_neon;
+        kernels.peak = convert_peak_f32_neon;
+    }
+#endif
+}
+
+const char* convert_get_backend(void) {
+    return kernels.name;
+}
+
+// --- Scalar reference implementations ---
+
+void convert_s16_to_f32_scalar(const Sint16 *in, float *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (float)in[i] * CONVERT_S16_SCALE;
+    }
+}
+
+void convert_s32_to_f32_scalar(const Sint32 *in, float *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (float)in[i] * CONVERT_S32_SCALE;
+    }
+}
+
+// SIMD variants only handle stereo and must match this summation order:
+// (left + right) * 0.5
+void convert_downmix_f32_scalar(const float *in, float *out, size_t frames, int channels) {
+    if (channels == 1) {
+        memmove(out, in, frames * sizeof(float));
+        return;
+    }
+
+    const float scale = 1.0f / (float)channels;
+    for (size_t f = 0; f < frames; f++) {
+        float sum = in[0];
+        for (int c = 1; c < channels; c++) {
+            sum += in[c];
+        }
+        out[f] = sum * scale;
+        in += channels;
+    }
+}
+
+void convert_peak_f32_scalar(const float *in, size_t count, float *out_min,
+                             float *out_max, float *out_sum_squares) {
+    float min = in[0];
+    float max = in[0];
+    float sum_squares = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        if (in[i] < min) min = in[i];
+        if (in[i] > max) max = in[i];
+        sum_squares += in[i] * in[i];
+    }
+    *out_min = min;
+    *out_max = max;
+    *out_sum_squares = sum_squares;
+}
+
+// --- Dispatched entry points ---
+
+void convert_s16_to_f32(const Sint16 *in, float *out, size_t count) {
+    kernels.s16_to_f32(in, out, count);
+}
+
+void convert_s32_to_f32(const Sint32 *in, float *out, size_t count) {
+    kernels.s32_to_f32(in, out, count);
+}
+
+void convert_f32_to_f32(const float *in, float *out, size_t count) {
+    if (in != out) {
+        memcpy(out, in, count * sizeof(float));
+    }
+}
+
+bool convert_is_supported(SDL_AudioFormat format) {
+    return format == SDL_AUDIO_S16 || format == SDL_AUDIO_S32 ||
+           format == SDL_AUDIO_F32;
+}
+
+bool convert_to_f32(SDL_AudioFormat format, const void *in, float *out, size_t count) {
+    switch (format) {
+    case SDL_AUDIO_S16:
+        convert_s16_to_f32((const Sint16 *)in, out, count);
+        return true;
+    case SDL_AUDIO_S32:
+        convert_s32_to_f32((const Sint32 *)in, out, count);
+        return true;
+    case SDL_AUDIO_F32:
+        convert_f32_to_f32((const float *)in, out, count);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void convert_downmix_f32(const float *in, float *out, size_t frames, int channels) {
+    kernels.downmix(in, out, frames, channels);
+}
+
+// Averaging runs of `factor` mono samples is a downmix of `factor` channels,
+// so the common 2x case gets the stereo SIMD kernel
+void convert_decimate_f32(const float *in, float *out, size_t out_count, int factor) {
+    kernels.downmix(in, out, out_count, factor < 1 ? 1 : factor);
+}
+
+void convert_peak_f32(const float *in, size_t count, float *out_min,
+                      float *out_max, float *out_sum_squares) {
+    kernels.peak(in, count, out_min, out_max, out_sum_squares);
+}
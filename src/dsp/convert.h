@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CONVERT_H
+#define CONVERT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL3/SDL.h>
+
+// Sample format conversion and channel layout kernels.
+//
+// Every function has a scalar reference implementation plus SSE2, AVX2 and
+// NEON variants where they help. convert_init() picks the fastest variant
+// the CPU supports; until it is called the scalar versions are used. All
+// variants produce bit-identical output to the scalar code, except where
+// noted below.
+
+// Select kernels for the running CPU. Call once at startup, before any
+// worker threads use the kernels.
+void convert_init(void);
+
+// Name of the selected kernel set ("scalar", "sse2", "avx2" or "neon")
+const char* convert_get_backend(void);
+
+// Integer/float PCM to float in [-1, 1). `count` is in samples, not frames.
+void convert_s16_to_f32(const Sint16 *in, float *out, size_t count);
+void convert_s32_to_f32(const Sint32 *in, float *out, size_t count);
+void convert_f32_to_f32(const float *in, float *out, size_t count);
+
+// Convert from an SDL audio format. Returns false for formats without a
+// kernel; see convert_is_supported().
+bool convert_is_supported(SDL_AudioFormat format);
+bool convert_to_f32(SDL_AudioFormat format, const void *in, float *out, size_t count);
+
+// Average all channels of each frame into one mono sample
+void convert_downmix_f32(const float *in, float *out, size_t frames, int channels);
+
+// Average each run of `factor` samples into one, producing out_count samples.
+// Same summation order as convert_downmix_f32 with `factor` channels.
+void convert_decimate_f32(const float *in, float *out, size_t out_count, int factor);
+
+// Minimum, maximum and sum of squares of `count` (at least 1) samples. The
+// SIMD variants add the squares in a different order, so the sum may differ
+// from the scalar one in the last bits; min and max are exact, except that
+// a zero may come back with either sign. NaN inputs are skipped, unless the
+// first sample is NaN, in which case min and max are NaN.
+void convert_peak_f32(const float *in, size_t count, float *out_min,
+                      float *out_max, float *out_sum_squares);
+
+#endif // CONVERT_H
@@ -0,0 +1,105 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "convert_impl.h"
+
+// Built with AVX2 enabled (see CMakeLists.txt); only called after
+// SDL_HasAVX2() confirms the CPU supports it
+#ifdef AUTOMARKER_HAVE_AVX2
+#include <immintrin.h>
+
+void convert_s16_to_f32_avx2(const Sint16 *in, float *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(CONVERT_S16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        __m256i wide = _mm256_cvtepi16_epi32(x);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(wide), scale));
+    }
+    convert_s16_to_f32_scalar(in + i, out + i, count - i);
+}
+
+void convert_s32_to_f32_avx2(const Sint32 *in, float *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(CONVERT_S32_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    convert_s32_to_f32_scalar(in + i, out + i, count - i);
+}
+
+void convert_downmix_f32_avx2(const float *in, float *out, size_t frames, int channels) {
+    if (channels != 2) {
+        convert_downmix_f32_scalar(in, out, frames, channels);
+        return;
+    }
+
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8) {
+        __m256 a = _mm256_loadu_ps(in + f * 2);
+        __m256 b = _mm256_loadu_ps(in + f * 2 + 8);
+        // In-lane shuffles leave frames ordered 0 1 4 5 | 2 3 6 7, so the
+        // 64-bit pairs are permuted back into order after the add
+        __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 mono = _mm256_mul_ps(_mm256_add_ps(l, r), half);
+        mono = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(mono),
+                                                      _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(out + f, mono);
+    }
+    convert_downmix_f32_scalar(in + f * 2, out + f, frames - f, 2);
+}
+
+void convert_peak_f32_avx2(const float *in, size_t count, float *out_min,
+                           float *out_max, float *out_sum_squares) {
+    // Same lane rules as the SSE2 version, so NaN handling matches the scalar
+    __m256 min = _mm256_set1_ps(in[0]);
+    __m256 max = min;
+    __m256 sum = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(in + i);
+        min = _mm256_min_ps(x, min);
+        max = _mm256_max_ps(x, max);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(x, x));
+    }
+
+    float lanes_min[8], lanes_max[8], lanes_sum[8];
+    _mm256_storeu_ps(lanes_min, min);
+    _mm256_storeu_ps(lanes_max, max);
+    _mm256_storeu_ps(lanes_sum, sum);
+    float total = 0.0f;
+    for (int lane = 0; lane < 8; lane++) {
+        if (lanes_min[lane] < lanes_min[0]) lanes_min[0] = lanes_min[lane];
+        if (lanes_max[lane] > lanes_max[0]) lanes_max[0] = lanes_max[lane];
+        total += lanes_sum[lane];
+    }
+    for (; i < count; i++) {
+        if (in[i] < lanes_min[0]) lanes_min[0] = in[i];
+        if (in[i] > lanes_max[0]) lanes_max[0] = in[i];
+        total += in[i] * in[i];
+    }
+
+    *out_min = lanes_min[0];
+    *out_max = lanes_max[0];
+    *out_sum_squares = total;
+}
+
+#endif // AUTOMARKER_HAVE_AVX2
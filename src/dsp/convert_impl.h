@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CONVERT_IMPL_H
+#define CONVERT_IMPL_H
+
+// Internal to the convert kernels: the per-ISA entry points and the scalar
+// references they fall back to for tails and unsupported layouts.
+
+#include "convert.h"
+
+#define CONVERT_S16_SCALE (1.0f / 32768.0f)
+#define CONVERT_S32_SCALE (1.0f / 2147483648.0f)
+
+void convert_s16_to_f32_scalar(const Sint16 *in, float *out, size_t count);
+void convert_s32_to_f32_scalar(const Sint32 *in, float *out, size_t count);
+void convert_downmix_f32_scalar(const float *in, float *out, size_t frames, int channels);
+void convert_peak_f32_scalar(const float *in, size_t count, float *out_min,
+                             float *out_max, float *out_sum_squares);
+
+// The AUTOMARKER_HAVE_* macros are set by CMake for the architectures whose
+// kernel files are built with the matching instruction set flags
+#ifdef AUTOMARKER_HAVE_SSE2
+void convert_s16_to_f32_sse2(const Sint16 *in, float *out, size_t count);
+void convert_s32_to_f32_sse2(const Sint32 *in, float *out, size_t count);
+void convert_downmix_f32_sse2(const float *in, float *out, size_t frames, int channels);
+void convert_peak_f32_sse2(const float *in, size_t count, float *out_min,
+                           float *out_max, float *out_sum_squares);
+#endif
+
+#ifdef AUTOMARKER_HAVE_AVX2
+void convert_s16_to_f32_avx2(const Sint16 *in, float *out, size_t count);
+void convert_s32_to_f32_avx2(const Sint32 *in, float *out, size_t count);
+void convert_downmix_f32_avx2(const float *in, float *out, size_t frames, int channels);
+void convert_peak_f32_avx2(const float *in, size_t count, float *out_min,
+                           float *out_max, float *out_sum_squares);
+#endif
+
+#ifdef AUTOMARKER_HAVE_NEON
+void convert_s16_to_f32_neon(const Sint16 *in, float *out, size_t count);
+void convert_s32_to_f32_neon(const Sint32 *in, float *out, size_t count);
+void convert_downmix_f32_neon(const float *in, float *out, size_t frames, int channels);
+void convert_peak_f32_neon(const float *in, size_t count, float *out_min,
+                           float *out_max, float *out_sum_squares);
+#endif
+
+#endif // CONVERT_IMPL_H
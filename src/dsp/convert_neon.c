@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "convert_impl.h"
+
+#ifdef AUTOMARKER_HAVE_NEON
+#include <arm_neon.h>
+
+void convert_s16_to_f32_neon(const Sint16 *in, float *out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t x = vld1q_s16(in + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+        vst1q_f32(out + i, vmulq_n_f32(lo, CONVERT_S16_SCALE));
+        vst1q_f32(out + i + 4, vmulq_n_f32(hi, CONVERT_S16_SCALE));
+    }
+    convert_s16_to_f32_scalar(in + i, out + i, count - i);
+}
+
+void convert_s32_to_f32_neon(const Sint32 *in, float *out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vcvtq_f32_s32(vld1q_s32(in + i));
+        vst1q_f32(out + i, vmulq_n_f32(x, CONVERT_S32_SCALE));
+    }
+    convert_s32_to_f32_scalar(in + i, out + i, count - i);
+}
+
+void convert_downmix_f32_neon(const float *in, float *out, size_t frames, int channels) {
+    if (channels != 2) {
+        convert_downmix_f32_scalar(in, out, frames, channels);
+        return;
+    }
+
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        float32x4x2_t lr = vld2q_f32(in + f * 2);
+        vst1q_f32(out + f, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), 0.5f));
+    }
+    convert_downmix_f32_scalar(in + f * 2, out + f, frames - f, 2);
+}
+
+void convert_peak_f32_neon(const float *in, size_t count, float *out_min,
+                           float *out_max, float *out_sum_squares) {
+    // vminq/vmaxq propagate NaN, so select on the scalar comparison instead:
+    // lanes start from in[0] and take x only when it is strictly smaller
+    // (larger). NaN inputs are skipped, and a NaN in[0] sticks.
+    float32x4_t min = vdupq_n_f32(in[0]);
+    float32x4_t max = min;
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vld1q_f32(in + i);
+        min = vbslq_f32(vcltq_f32(x, min), x, min);
+        max = vbslq_f32(vcgtq_f32(x, max), x, max);
+        sum = vmlaq_f32(sum, x, x);
+    }
+
+    // Horizontal reductions are AArch64 only, which is the only NEON target
+    float min_all = vminvq_f32(min);
+    float max_all = vmaxvq_f32(max);
+    float total = vaddvq_f32(sum);
+    for (; i < count; i++) {
+        if (in[i] < min_all) min_all = in[i];
+        if (in[i] > max_all) max_all = in[i];
+        total += in[i] * in[i];
+    }
+
+    *out_min = min_all;
+    *out_max = max_all;
+    *out_sum_squares = total;
+}
+
+#endif // AUTOMARKER_HAVE_NEON
@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "convert_impl.h"
+
+#ifdef AUTOMARKER_HAVE_SSE2
+#include <emmintrin.h>
+
+void convert_s16_to_f32_sse2(const Sint16 *in, float *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(CONVERT_S16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        // Sign-extend by placing each 16-bit value in the top half of a lane
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    convert_s16_to_f32_scalar(in + i, out + i, count - i);
+}
+
+void convert_s32_to_f32_sse2(const Sint32 *in, float *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(CONVERT_S32_SCALE);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+    }
+    convert_s32_to_f32_scalar(in + i, out + i, count - i);
+}
+
+void convert_downmix_f32_sse2(const float *in, float *out, size_t frames, int channels) {
+    if (channels != 2) {
+        convert_downmix_f32_scalar(in, out, frames, channels);
+        return;
+    }
+
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        __m128 a = _mm_loadu_ps(in + f * 2);
+        __m128 b = _mm_loadu_ps(in + f * 2 + 4);
+        __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + f, _mm_mul_ps(_mm_add_ps(l, r), half));
+    }
+    convert_downmix_f32_scalar(in + f * 2, out + f, frames - f, 2);
+}
+
+void convert_peak_f32_sse2(const float *in, size_t count, float *out_min,
+                           float *out_max, float *out_sum_squares) {
+    // Every lane starts from in[0] and, with x as the first operand, takes x
+    // only when it is strictly smaller (larger): the scalar comparison. NaN
+    // inputs are then skipped the same way, and a NaN in[0] sticks.
+    __m128 min = _mm_set1_ps(in[0]);
+    __m128 max = min;
+    __m128 sum = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        min = _mm_min_ps(x, min);
+        max = _mm_max_ps(x, max);
+        sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+    }
+
+    float lanes_min[4], lanes_max[4], lanes_sum[4];
+    _mm_storeu_ps(lanes_min, min);
+    _mm_storeu_ps(lanes_max, max);
+    _mm_storeu_ps(lanes_sum, sum);
+    float total = 0.0f;
+    for (int lane = 0; lane < 4; lane++) {
+        if (lanes_min[lane] < lanes_min[0]) lanes_min[0] = lanes_min[lane];
+        if (lanes_max[lane] > lanes_max[0]) lanes_max[0] = lanes_max[lane];
+        total += lanes_sum[lane];
+    }
+    for (; i < count; i++) {
+        if (in[i] < lanes_min[0]) lanes_min[0] = in[i];
+        if (in[i] > lanes_max[0]) lanes_max[0] = in[i];
+        total += in[i] * in[i];
+    }
+
+    *out_min = lanes_min[0];
+    *out_max = lanes_max[0];
+    *out_sum_squares = total;
+}
+
+#endif // AUTOMARKER_HAVE_SSE2
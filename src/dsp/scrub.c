@@ -0,0 +1,207 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "scrub.h"
+#include <math.h>
+
+// Grain length. Long enough to hear pitch and timbre, short enough that
+// the sound follows the pointer without audible lag.
+#define SCRUB_GRAIN_MS 40
+
+// Fastest the source is read, in source frames per output frame
+#define SCRUB_MAX_RATE 4.0
+
+// Pointer velocity at which grains play at full level; slower drags fade
+// towards silence so a still pointer doesn't buzz
+#define SCRUB_FULL_LEVEL_RATE 0.25
+
+// How much of the newly measured velocity each grain takes on
+#define SCRUB_RATE_SMOOTHING 0.5
+
+// Beyond this many hops away the cursor jumps to the pointer instead of
+// racing after it
+#define SCRUB_JUMP_HOPS 16
+
+bool scrub_engine_init(ScrubEngine *engine, int channels, int sample_rate) {
+    SDL_zerop(engine);
+    scrub_engine_reset(engine);
+    if (channels <= 0 || sample_rate <= 0) return false;
+
+    int grain_frames = (int)((Sint64)sample_rate * SCRUB_GRAIN_MS / 1000) & ~1;
+    if (grain_frames < 2) grain_frames = 2;
+
+    engine->window = SDL_malloc((size_t)grain_frames * sizeof(float));
+    engine->output = SDL_malloc((size_t)SCRUB_BLOCK_FRAMES * channels * sizeof(float));
+    if (!engine->window || !engine->output) {
+        scrub_engine_free(engine);
+        return false;
+    }
+
+    // Periodic, so windows half a grain apart sum to exactly one
+    for (int i = 0; i < grain_frames; i++) {
+        engine->window[i] = (float)(0.5 - 0.5 * cos(2.0 * SDL_PI_D * i / grain_frames));
+    }
+    engine->channels = channels;
+    engine->grain_frames = grain_frames;
+    engine->hop_frames = grain_frames / 2;
+    return true;
+}
+
+void scrub_engine_free(ScrubEngine *engine) {
+    SDL_free(engine->window);
+    SDL_free(engine->output);
+    engine->window = NULL;
+    engine->output = NULL;
+    scrub_engine_reset(engine);
+}
+
+void scrub_engine_reset(ScrubEngine *engine) {
+    engine->grains[0].active = false;
+    engine->grains[1].active = false;
+    engine->next_grain = 0;
+    engine->hop_phase = 0;
+    engine->active = false;
+    engine->releasing = false;
+    engine->handoff = false;
+    engine->handoff_grain = -1;
+    engine->resume_frame = -1;
+}
+
+static void start_grain(ScrubEngine *engine, int slot, double start, double rate, float gain) {
+    ScrubGrain *grain = &engine->grains[slot];
+    grain->start = start;
+    grain->rate = rate;
+    grain->gain = gain;
+    grain->phase = 0;
+    grain->active = gain > 0.0f;
+}
+
+void scrub_engine_start(ScrubEngine *engine, Sint64 frame, Sint64 playing_from) {
+    scrub_engine_reset(engine);
+    engine->active = true;
+    engine->cursor = (double)frame;
+    engine->rate = 0.0;
+
+    // Take over linear playback as a grain already at its peak, so it fades
+    // out while the first scrub grain fades in
+    if (playing_from >= 0) {
+        start_grain(engine, 1, (double)(playing_from - engine->hop_frames), 1.0, 1.0f);
+        engine->grains[1].phase = engine->hop_frames;
+    }
+}
+
+void scrub_engine_release(ScrubEngine *engine, Sint64 frame, bool handoff) {
+    if (!engine->active) return;
+    engine->cursor = (double)frame;
+    engine->releasing = true;
+    engine->handoff = handoff;
+}
+
+// Start the grain for the hop that begins now
+static void begin_hop(ScrubEngine *engine, Sint64 target) {
+    const int slot = engine->next_grain;
+    engine->next_grain ^= 1;
+
+    if (engine->releasing) {
+        // Linear playback fades in like a grain, but stays once it is in
+        if (engine->handoff && engine->handoff_grain < 0) {
+            engine->handoff_grain = slot;
+            start_grain(engine, slot, engine->cursor, 1.0, 1.0f);
+        }
+        return;
+    }
+
+    const double hop = engine->hop_frames;
+    double distance = (double)target - engine->cursor;
+    if (fabs(distance) > SCRUB_JUMP_HOPS * hop) {
+        engine->cursor = (double)target;
+        distance = 0.0;
+    }
+
+    // Read at the speed that would reach the pointer by the next hop
+    double wanted = distance / hop;
+    if (wanted > SCRUB_MAX_RATE) wanted = SCRUB_MAX_RATE;
+    if (wanted < -SCRUB_MAX_RATE) wanted = -SCRUB_MAX_RATE;
+    engine->rate += (wanted - engine->rate) * SCRUB_RATE_SMOOTHING;
+
+    const double level = fabs(engine->rate) / SCRUB_FULL_LEVEL_RATE;
+    start_grain(engine, slot, engine->cursor, engine->rate, level > 1.0 ? 1.0f : (float)level);
+    engine->cursor += engine->rate * hop;
+}
+
+// Add `gain` times the source at fractional frame `position` to `out`,
+// interpolating linearly. Frames outside the source are silent.
+static void add_frame(const float *samples, Sint64 available, int channels,
+                      double position, float gain, float *out) {
+    if (position < 0.0) return;
+    const Sint64 index = (Sint64)position;
+    if (index >= available) return;
+
+    const float fraction = (float)(position - (double)index);
+    const float *a = samples + index * channels;
+    const float *b = index + 1 < available ? a + channels : a;
+    for (int c = 0; c < channels; c++) {
+        out[c] += gain * (a[c] + fraction * (b[c] - a[c]));
+    }
+}
+
+int scrub_engine_render(ScrubEngine *engine, const float *samples, Sint64 available,
+                        Sint64 target, int frames) {
+    if (!engine->active || !engine->output) return 0;
+    if (frames > SCRUB_BLOCK_FRAMES) frames = SCRUB_BLOCK_FRAMES;
+    if (!samples) available = 0;
+
+    const int channels = engine->channels;
+    SDL_memset(engine->output, 0, (size_t)frames * channels * sizeof(float));
+
+    for (int i = 0; i < frames; i++) {
+        if (engine->hop_phase == 0) {
+            begin_hop(engine, target);
+        }
+
+        float *out = engine->output + (size_t)i * channels;
+        for (int g = 0; g < 2; g++) {
+            ScrubGrain *grain = &engine->grains[g];
+            if (!grain->active) continue;
+            add_frame(samples, available, channels, grain->start + grain->phase * grain->rate,
+                      grain->gain * engine->window[grain->phase], out);
+            if (++grain->phase >= engine->grain_frames) {
+                grain->active = false;
+            }
+        }
+        if (++engine->hop_phase >= engine->hop_frames) {
+            engine->hop_phase = 0;
+        }
+
+        if (!engine->releasing) continue;
+        if (engine->handoff_grain >= 0) {
+            // Faded in, and the last scrub grain has faded out with it
+            const ScrubGrain *grain = &engine->grains[engine->handoff_grain];
+            if (grain->phase >= engine->hop_frames) {
+                engine->resume_frame = (Sint64)grain->start + engine->hop_frames;
+                engine->active = false;
+                return i + 1;
+            }
+        } else if (!engine->handoff && !engine->grains[0].active && !engine->grains[1].active) {
+            engine->active = false;
+            return i + 1;
+        }
+    }
+    return frames;
+}
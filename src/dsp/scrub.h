@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SCRUB_H
+#define SCRUB_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+
+// Granular scrubbing for playhead drags.
+//
+// While the playhead is dragged, the engine plays short Hann-windowed
+// grains read from around the pointer. Grains overlap by half, so
+// consecutive ones crossfade and sum to unity gain. Each grain reads the
+// source at the rate the pointer is moving (backwards when it moves left):
+// a fast drag sounds sped up, a slow one slowed down, and a still pointer
+// fades to silence. Big jumps move straight to the pointer.
+//
+// Everything a render needs is allocated by scrub_engine_init(), so the
+// audio callback can run the engine without allocating or locking. The
+// engine itself is not thread-safe: only the callback may touch it while
+// the device is running.
+
+// Output frames rendered per scrub_engine_render() call, at most
+#define SCRUB_BLOCK_FRAMES 1024
+
+typedef struct {
+    double start;       // Source frame read at phase 0
+    double rate;        // Source frames per output frame, negative backwards
+    float gain;
+    int phase;          // Output frames into the grain
+    bool active;
+} ScrubGrain;
+
+typedef struct {
+    int channels;
+    int grain_frames;   // Grain length, an even number of frames
+    int hop_frames;     // Distance between grain starts, half a grain
+    float *window;      // Periodic Hann window, grain_frames values
+    float *output;      // Interleaved render output, SCRUB_BLOCK_FRAMES frames
+
+    ScrubGrain grains[2];
+    int next_grain;     // Slot the next grain goes into
+    int hop_phase;      // Output frames since the last grain boundary
+    double cursor;      // Source frame the next grain starts at
+    double rate;        // Smoothed pointer velocity, source frames per output frame
+    bool active;
+    bool releasing;     // Start no more scrub grains
+    bool handoff;       // Continue into linear playback once released
+    int handoff_grain;  // Slot of the grain fading linear playback in, or -1
+    Sint64 resume_frame; // Where linear playback continues after a handoff, or -1
+} ScrubEngine;
+
+// Allocate the window and the output block for `channels` channels at
+// `sample_rate`. Returns false on allocation failure.
+bool scrub_engine_init(ScrubEngine *engine, int channels, int sample_rate);
+void scrub_engine_free(ScrubEngine *engine);
+
+// Start scrubbing at `frame`. If audio was playing linearly from
+// `playing_from`, the first grain fades it out; pass -1 if nothing was.
+void scrub_engine_start(ScrubEngine *engine, Sint64 frame, Sint64 playing_from);
+
+// Stop scrubbing at `frame`. The grains already playing fade out; with
+// `handoff`, linear playback from `frame` fades in under them, and once it
+// has, resume_frame says where to continue.
+void scrub_engine_release(ScrubEngine *engine, Sint64 frame, bool handoff);
+
+// Drop everything at once, e.g. when the device stops
+void scrub_engine_reset(ScrubEngine *engine);
+
+static inline bool scrub_engine_active(const ScrubEngine *engine) {
+    return engine->active;
+}
+
+// Render up to `frames` (at most SCRUB_BLOCK_FRAMES) frames into
+// engine->output, steering towards `target`. Reads `samples`, interleaved,
+// of which `available` frames are valid. Returns the frames rendered,
+// fewer than asked once the engine has finished releasing.
+int scrub_engine_render(ScrubEngine *engine, const float *samples, Sint64 available,
+                        Sint64 target, int frames);
+
+#endif // SCRUB_H
@@ -0,0 +1,39 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#include <stddef.h>
+#include <SDL3/SDL.h>
+
+// 64-bit FNV-1a, used to derive cache keys. Not cryptographic.
+
+#define FNV1A_OFFSET 14695981039346656037ULL
+#define FNV1A_PRIME 1099511628211ULL
+
+static inline Uint64 fnv1a(Uint64 hash, const void *data, size_t len) {
+    const Uint8 *bytes = (const Uint8 *)data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+#endif // FNV1A_H
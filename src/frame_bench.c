@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_bench.h"
+#include "app_paths.h"
+#include <math.h>
+#include <stdio.h>
+
+#define FIXTURE_NAME "bench-fixture.wav"
+#define FIXTURE_RATE 44100
+#define FIXTURE_CHANNELS 2
+#define FIXTURE_SECONDS 180
+#define FIXTURE_BEAT_FRAMES (FIXTURE_RATE / 2)
+
+// Frames spent panning across the track at each zoom level
+#define PAN_FRAMES 240
+
+static const float bench_zoom_levels[] = {1.0f, 8.0f, 50.0f, 400.0f};
+
+// One fixture sample: a decaying 60 Hz thump on every beat over a quiet
+// bed of noise from a fixed-seed LCG, so every run draws the same thing
+static Sint16 fixture_sample(Sint64 frame, Uint32 *seed) {
+  *seed = *seed * 1664525u + 1013904223u;
+  const float noise = ((float)(*seed >> 9) / (float)(1u << 23) - 0.5f) * 0.1f;
+
+  const float t = (float)(frame % FIXTURE_BEAT_FRAMES) / FIXTURE_RATE;
+  const float thump = expf(-t * 12.0f) * sinf(2.0f * SDL_PI_F * 60.0f * t);
+  return (Sint16)((thump * 0.8f + noise) * 32767.0f);
+}
+
+static bool write_fixture_file(const char *path) {
+  const Uint32 data_bytes = (Uint32)FIXTURE_SECONDS * FIXTURE_RATE * FIXTURE_CHANNELS * 2;
+  SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+  if (!io) return false;
+
+  bool ok = SDL_WriteIO(io, "RIFF", 4) == 4 &&
+            SDL_WriteU32LE(io, 36 + data_bytes) &&
+            SDL_WriteIO(io, "WAVEfmt ", 8) == 8 &&
+            SDL_WriteU32LE(io, 16) &&
+            SDL_WriteU16LE(io, 1) &&  // PCM
+            SDL_WriteU16LE(io, FIXTURE_CHANNELS) &&
+            SDL_WriteU32LE(io, FIXTURE_RATE) &&
+            SDL_WriteU32LE(io, FIXTURE_RATE * FIXTURE_CHANNELS * 2) &&
+            SDL_WriteU16LE(io, FIXTURE_CHANNELS * 2) &&
+            SDL_WriteU16LE(io, 16) &&
+            SDL_WriteIO(io, "data", 4) == 4 &&
+            SDL_WriteU32LE(io, data_bytes);
+
+  Uint32 seed = 1;
+  Sint16 block[4096 * FIXTURE_CHANNELS];
+  const Sint64 total = (Sint64)FIXTURE_SECONDS * FIXTURE_RATE;
+  for (Sint64 frame = 0; ok && frame < total; frame += 4096) {
+    const int count = (int)SDL_min(total - frame, 4096);
+    for (int i = 0; i < count; i++) {
+      const Sint16 sample = fixture_sample(frame + i, &seed);
+      for (int c = 0; c < FIXTURE_CHANNELS; c++) {
+        block[i * FIXTURE_CHANNELS + c] = SDL_Swap16LE(sample);
+      }
+    }
+    const size_t bytes = (size_t)count * FIXTURE_CHANNELS * sizeof(Sint16);
+    ok = SDL_WriteIO(io, block, bytes) == bytes;
+  }
+
+  ok = SDL_CloseIO(io) && ok;
+  if (!ok) {
+    SDL_RemovePath(path);
+  }
+  return ok;
+}
+
+bool frame_bench_write_fixture(char *path, size_t path_size) {
+  char *pref_path = SDL_GetPrefPath(UPDATER_ORG, UPDATER_APP);
+  if (!pref_path) return false;
+  snprintf(path, path_size, "%s%s", pref_path, FIXTURE_NAME);
+  SDL_free(pref_path);
+
+  SDL_PathInfo info;
+  if (SDL_GetPathInfo(path, &info) && info.type == SDL_PATHTYPE_FILE) {
+    return true;
+  }
+  printf("Writing bench fixture: %s\n", path);
+  return write_fixture_file(path);
+}
+
+void frame_bench_set_view(AppState *state, int frame) {
+  const int level_count = (int)SDL_arraysize(bench_zoom_levels);
+  state->waveform_view.zoom = bench_zoom_levels[(frame / PAN_FRAMES) % level_count];
+  state->waveform_view.scroll = (float)(frame % PAN_FRAMES) / (PAN_FRAMES - 1);
+}
+
+static int compare_floats(const void *a, const void *b) {
+  const float x = *(const float *)a;
+  const float y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+// p-th percentile (0..1) of `count` sorted samples
+static float percentile(const float *sorted, int count, float p) {
+  return sorted[(int)(p * (count - 1) + 0.5f)];
+}
+
+void frame_bench_report(float *frame_ms, int count, Sint64 draw_calls) {
+  if (count <= 0) return;
+
+  SDL_qsort(frame_ms, (size_t)count, sizeof(float), compare_floats);
+  printf("Frame bench: %d frames at %dx%d, p50 %.3f ms, p99 %.3f ms, "
+         "max %.3f ms, %.1f draw calls per frame\n",
+         count, FRAME_BENCH_WIDTH, FRAME_BENCH_HEIGHT,
+         percentile(frame_ms, count, 0.50f), percentile(frame_ms, count, 0.99f),
+         frame_ms[count - 1], (double)draw_calls / count);
+}
@@ -0,0 +1,45 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FRAME_BENCH_H
+#define FRAME_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "app_state.h"
+
+// Headless frame-time benchmark: `automarker --bench [frames]` renders
+// frames with the offscreen video driver against a generated fixture and
+// prints frame time percentiles, then exits.
+#define FRAME_BENCH_DEFAULT_FRAMES 960
+#define FRAME_BENCH_WIDTH 1920
+#define FRAME_BENCH_HEIGHT 1080
+
+// Write the fixture, a synthetic track with a beat every half second,
+// next to the app's cache unless it is already there. Its contents never
+// change, so later runs reuse it and its cached analysis.
+bool frame_bench_write_fixture(char *path, size_t path_size);
+
+// Set the waveform view for frame `frame`: each zoom level in turn is
+// panned across the whole track
+void frame_bench_set_view(AppState *state, int frame);
+
+// Print percentiles of `count` frame times and the average draw calls
+void frame_bench_report(float *frame_ms, int count, Sint64 draw_calls);
+
+#endif // FRAME_BENCH_H
@@ -37,6 +37,17 @@
 #include "ui/components.h"
 #include "connections/curl_manager.h"
 #include "connections/premiere_pro.h"
+#include "frame_bench.h"
+
+// Redraw pacing. Frames are drawn at most once per display refresh, or
+// every ACTIVE_FRAME_MS if the refresh rate is unknown, however many events
+// arrive. While something is moving (playback, a load, network requests)
+// one is drawn every refresh; otherwise the loop sleeps in SDL_WaitEventTimeout until an event arrives, waking every
+// IDLE_POLL_MS (HIDDEN_POLL_MS when the window can't be seen) to notice
+// changes made by background threads.
+#define ACTIVE_FRAME_MS 16
+#define IDLE_POLL_MS 250
+#define HIDDEN_POLL_MS 1000
 
 // Health check retry settings
 #define CEP_HEALTH_RETRY_INTERVAL_MS 3000
@@ -67,11 +78,17 @@ static void cep_health_check_callback(bool healthy, void *userdata) {
 static inline Clay_Dimensions SDL_MeasureText(Clay_StringSlice text,
                                               Clay_TextElementConfig *config,
                                               void *userData) {
-  TTF_Font **fonts = userData;
-  TTF_Font *font = fonts[config->fontId];
-  int width, height;
-
-  if (!TTF_GetStringSize(font, text.chars, text.length, &width, &height)) {
+  Clay_SDL3RendererData *rendererData = userData;
+  TTF_Font *font = rendererData->fonts[config->fontId];
+  const SDL_Color color = {config->textColor.r, config->textColor.g,
+                           config->textColor.b, config->textColor.a};
+  int width = 0, height = 0;
+
+  bool measured = rendererData->textCache
+      ? text_cache_measure(rendererData->textCache, font, text.chars,
+                           text.length, color, &width, &height)
+      : TTF_GetStringSize(font, text.chars, text.length, &width, &height);
+  if (!measured) {
     SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to measure text: %s",
                  SDL_GetError());
   }
@@ -79,13 +96,154 @@ static inline Clay_Dimensions SDL_MeasureText(Clay_StringSlice text,
   return (Clay_Dimensions){(float)width, (float)height};
 }
 
+static RedrawSnapshot take_redraw_snapshot(AppState *state) {
+  AudioState *audio = state->audio_state;
+  RedrawSnapshot snapshot = {0};
+
+  SDL_LockMutex(audio->data_mutex);
+  snapshot.audio_status = audio->status;
+  snapshot.progress_permille = (int)(audio->processing_progress * 1000.0f);
+  snapshot.decoded_frames = pcm_buffer_frames(audio->pcm);
+  snapshot.beat_count = audio->beat_count;
+  SDL_UnlockMutex(audio->data_mutex);
+
+  snapshot.playback_state = audio->playback_state;
+  snapshot.playback_position = audio_state_get_playback_position(audio);
+  snapshot.connected_app = SDL_GetAtomicInt(&state->connected_app);
+  snapshot.cep_health_status = SDL_GetAtomicInt(&state->cep_health_status);
+  snapshot.cep_install_status = SDL_GetAtomicInt(&state->cep_install_state.status);
+  snapshot.update_status = state->updater_state->status;
+  snapshot.download_permille = (int)(state->updater_state->download_progress * 1000.0);
+  snapshot.requests_in_flight = state->curl_manager->still_running;
+  return snapshot;
+}
+
+static bool redraw_snapshot_equal(const RedrawSnapshot *a, const RedrawSnapshot *b) {
+  return a->audio_status == b->audio_status &&
+         a->progress_permille == b->progress_permille &&
+         a->decoded_frames == b->decoded_frames &&
+         a->beat_count == b->beat_count &&
+         a->playback_state == b->playback_state &&
+         a->playback_position == b->playback_position &&
+         a->connected_app == b->connected_app &&
+         a->cep_health_status == b->cep_health_status &&
+         a->cep_install_status == b->cep_install_status &&
+         a->update_status == b->update_status &&
+         a->download_permille == b->download_permille &&
+         a->requests_in_flight == b->requests_in_flight;
+}
+
+// Milliseconds between frames while something moves: the refresh interval
+// of the display the window is on
+static Uint32 active_frame_ms(const AppState *state) {
+  const SDL_DisplayMode *mode =
+      SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(state->window));
+  if (!mode || mode->refresh_rate <= 0.0f) {
+    return ACTIVE_FRAME_MS;
+  }
+  return SDL_max((Uint32)(1000.0f / mode->refresh_rate), 1);
+}
+
+// Whether the screen is expected to change soon without any input
+static bool is_animating(const AppState *state, const RedrawSnapshot *snapshot) {
+  return snapshot->playback_state == PLAYBACK_PLAYING ||
+         snapshot->audio_status == STATUS_DECODE ||
+         snapshot->audio_status == STATUS_BEAT_ANALYSIS ||
+         snapshot->requests_in_flight > 0 ||
+         state->waveform_interaction_state != INTERACTION_NONE;
+}
+
 static void HandleClayErrors(Clay_ErrorData errorData) {
   printf("%s", errorData.errorText.chars);
 }
 
+// Lay out, render and present one frame
+static void draw_frame(AppState *state) {
+  PerfHud *hud = &state->perf_hud;
+  state->is_tooltip_visible = false;
+  state->is_hovering_scrollbar_thumb = false;
+
+  const Uint64 frame_started = perf_hud_begin(hud);
+  Clay_BeginLayout();
+
+  build_ui(state);
+
+  Clay_RenderCommandArray render_commands = Clay_EndLayout();
+  perf_hud_end(hud, PERF_LAYOUT, frame_started);
+
+  Clay_ElementData waveform_element = Clay_GetElementData(CLAY_ID("WaveformDisplay"));
+  if (waveform_element.found) {
+    state->waveform_bbox = waveform_element.boundingBox;
+  }
+
+  SDL_SetRenderDrawColor(state->rendererData.renderer, 0, 0, 0, 255);
+  SDL_RenderClear(state->rendererData.renderer);
+
+  const Uint64 render_started = perf_hud_begin(hud);
+  SDL_Clay_RenderClayCommands(&state->rendererData, &render_commands);
+  perf_hud_end(hud, PERF_RENDER, render_started);
+
+  perf_hud_collect(hud, &state->rendererData, state->audio_state);
+  perf_hud_draw(hud, state->rendererData.renderer);
+
+  const Uint64 present_started = perf_hud_begin(hud);
+  SDL_RenderPresent(state->rendererData.renderer);
+  perf_hud_end(hud, PERF_PRESENT, present_started);
+  perf_hud_presented(hud);
+  perf_hud_end(hud, PERF_FRAME, frame_started);
+}
+
+// Load the bench fixture, then time `frames` frames while the waveform is
+// panned and zoomed. Loading and analysis aren't timed.
+static bool run_frame_bench(AppState *state, int frames) {
+  char path[1024];
+  if (!frame_bench_write_fixture(path, sizeof(path))) {
+    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not write the bench fixture: %s",
+                 SDL_GetError());
+    return false;
+  }
+
+  // No playback device; the fixture's analysis is cached after the first run
+  state->audio_state->headless = true;
+  if (!audio_state_process_file(state->audio_state, path)) {
+    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not load the bench fixture");
+    return false;
+  }
+
+  float *frame_ms = SDL_malloc((size_t)frames * sizeof(float));
+  if (!frame_ms) {
+    return false;
+  }
+
+  const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+  Sint64 draw_calls = 0;
+  for (int i = 0; i < frames; i++) {
+    frame_bench_set_view(state, i);
+    const Uint64 started = SDL_GetPerformanceCounter();
+    draw_frame(state);
+    frame_ms[i] = (float)((double)(SDL_GetPerformanceCounter() - started) * ms_per_tick);
+    draw_calls += state->rendererData.stats.drawCalls;
+  }
+
+  frame_bench_report(frame_ms, frames, draw_calls);
+  SDL_free(frame_ms);
+  return true;
+}
+
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
-  (void)argc;
-  (void)argv;
+  // --bench [frames]: time frames offscreen and exit
+  int bench_frames = 0;
+  for (int i = 1; i < argc; i++) {
+    if (SDL_strcmp(argv[i], "--bench") == 0) {
+      bench_frames = i + 1 < argc ? SDL_atoi(argv[i + 1]) : 0;
+      if (bench_frames <= 0) {
+        bench_frames = FRAME_BENCH_DEFAULT_FRAMES;
+      }
+    }
+  }
+  if (bench_frames > 0) {
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+  }
 
   if (!TTF_Init()) {
     return SDL_APP_FAILURE;
@@ -103,8 +261,10 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
   }
   *appstate = state;
 
-  if (!SDL_CreateWindowAndRenderer("automarker", 1000, 480, 0, &state->window,
-                                   &state->rendererData.renderer)) {
+  const int window_width = bench_frames > 0 ? FRAME_BENCH_WIDTH : 1000;
+  const int window_height = bench_frames > 0 ? FRAME_BENCH_HEIGHT : 480;
+  if (!SDL_CreateWindowAndRenderer("automarker", window_width, window_height, 0,
+                                   &state->window, &state->rendererData.renderer)) {
     SDL_LogError(SDL_LOG_CATEGORY_ERROR,
                  "Failed to create window and renderer: %s", SDL_GetError());
     return SDL_APP_FAILURE;
@@ -121,6 +281,10 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
     return SDL_APP_FAILURE;
   }
 
+  // Without the cache, text is measured and shaped from scratch each frame
+  state->rendererData.textCache =
+      text_cache_create(state->rendererData.textEngine);
+
   state->rendererData.fonts = SDL_calloc(2, sizeof(TTF_Font *));
   if (!state->rendererData.fonts) {
     SDL_LogError(SDL_LOG_CATEGORY_ERROR,
@@ -173,95 +337,12 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
   SDL_GetWindowSize(state->window, &width, &height);
   Clay_Initialize(clayMemory, (Clay_Dimensions){(float)width, (float)height},
                   (Clay_ErrorHandler){HandleClayErrors, 0});
-  Clay_SetMeasureTextFunction(SDL_MeasureText, state->rendererData.fonts);
+  Clay_SetMeasureTextFunction(SDL_MeasureText, &state->rendererData);
 
-  // Load Icons
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "file.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/file.svg");
-#endif
-  state->file_icon = IMG_Load(resource_path);
-  if (!state->file_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load file icon: %s",
-                 SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "play_pause.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/play_pause.svg");
-#endif
-  state->play_icon = IMG_Load(resource_path);
-  if (!state->play_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load play icon: %s",
-                 SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "send.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/send.svg");
-#endif
-  state->send_icon = IMG_Load(resource_path);
-  if (!state->send_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load send icon: %s",
-                 SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "remove.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/remove.svg");
-#endif
-  state->remove_icon = IMG_Load(resource_path);
-  if (!state->remove_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load remove icon: %s",
-                 SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "help.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/help.svg");
-#endif
-  state->help_icon = IMG_Load(resource_path);
-  if (!state->help_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load help icon: %s",
-                 SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "mark_in.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/mark_in.svg");
-#endif
-  state->mark_in_icon = IMG_Load(resource_path);
-  if (!state->mark_in_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load mark in icon: %s",
-                 SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "mark_out.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/mark_out.svg");
-#endif
-  state->mark_out_icon = IMG_Load(resource_path);
-  if (!state->mark_out_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load mark out icon: %s",
-                 SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
-#ifdef __APPLE__
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "update.svg");
-#else
-  snprintf(resource_path, sizeof(resource_path), "%s%s", state->base_path, "resources/update.svg");
-#endif
-  state->update_icon = IMG_Load(resource_path);
-  if (!state->update_icon) {
-    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load update icon: %s",
-                 SDL_GetError());
+  // Load icons into one texture, rasterised for the window's pixel density
+  if (!icon_atlas_init(&state->icons, state->rendererData.renderer,
+                       state->base_path,
+                       SDL_GetWindowPixelDensity(state->window))) {
     return SDL_APP_FAILURE;
   }
 
@@ -307,10 +388,16 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
   state->cep_health_last_check_time = 0;
   state->cep_health_retry_count = 0;
 
+  if (bench_frames > 0) {
+    return run_frame_bench(state, bench_frames) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+  }
+
   if (state->updater_state->check_on_startup) {
       updater_check_for_updates(state->updater_state, state->curl_manager);
   }
 
+  state->pending_frames = 1;
+
   *appstate = state;
   return SDL_APP_CONTINUE;
 }
@@ -318,6 +405,11 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
   SDL_AppResult ret_val = SDL_APP_CONTINUE;
 
+  // Input, window and expose events can all change what's on screen. The
+  // second frame picks up state changed by click handlers, which Clay
+  // only runs while the first one is being laid out.
+  ((AppState *)appstate)->pending_frames = 2;
+
   switch (event->type) {
   case SDL_EVENT_QUIT:
     ret_val = SDL_APP_SUCCESS;
@@ -326,6 +418,13 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
     Clay_SetLayoutDimensions((Clay_Dimensions){(float)event->window.data1,
                                                (float)event->window.data2});
     break;
+  case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+  case SDL_EVENT_WINDOW_DISPLAY_SCALE_CHANGED: {
+    // Moved to a display with another scale: re-rasterise the icons
+    AppState *state = (AppState *)appstate;
+    icon_atlas_update(&state->icons, state->rendererData.renderer,
+                      SDL_GetWindowPixelDensity(state->window));
+  } break;
   case SDL_EVENT_MOUSE_MOTION: {
     AppState *state = (AppState *)appstate;
     Clay_SetPointerState((Clay_Vector2){event->motion.x, event->motion.y},
@@ -359,45 +458,51 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
         float click_x = event->motion.x - state->waveform_bbox.x;
         float waveform_width = state->waveform_bbox.width;
 
-        unsigned int visibleSamples =
-            (unsigned int)(audio_state->sample->buffer_size /
-                           sizeof(float) / state->waveform_view.zoom);
-        unsigned int maxStartSample =
-            (audio_state->sample->buffer_size / sizeof(float)) -
-            visibleSamples;
-        unsigned int startSample =
-            (unsigned int)(state->waveform_view.scroll * maxStartSample);
-        unsigned int clicked_sample =
-            startSample +
-            (unsigned int)((click_x / waveform_width) * visibleSamples);
+        Sint64 visibleFrames =
+            (Sint64)((double)audio_state->total_frames /
+                     state->waveform_view.zoom);
+        Sint64 maxStartFrame =
+            audio_state->total_frames - visibleFrames;
+        Sint64 startFrame =
+            (Sint64)(state->waveform_view.scroll * (double)maxStartFrame);
+        Sint64 clicked_frame =
+            startFrame +
+            (Sint64)((double)(click_x / waveform_width) * visibleFrames);
 
         switch (state->waveform_interaction_state) {
         case INTERACTION_DRAGGING_PLAYHEAD:
-          audio_state_set_playback_position(audio_state, clicked_sample);
+          perf_hud_note_input(&state->perf_hud, event->motion.timestamp);
+          if (audio_state->scrubbing) {
+            audio_state_scrub_to(audio_state, clicked_frame);
+          } else {
+            audio_state_set_playback_position(audio_state, clicked_frame);
+          }
           break;
         case INTERACTION_DRAGGING_START_MARKER:
-          if (clicked_sample < audio_state->selection_end) {
-            audio_state->selection_start = clicked_sample;
+          if (clicked_frame < audio_state->selection_end) {
+            audio_state_set_selection(audio_state, clicked_frame,
+                                      audio_state->selection_end);
           }
           break;
         case INTERACTION_DRAGGING_END_MARKER:
-          if (clicked_sample > audio_state->selection_start) {
-            audio_state->selection_end = clicked_sample;
+          if (clicked_frame > audio_state->selection_start) {
+            audio_state_set_selection(audio_state, audio_state->selection_start,
+                                      clicked_frame);
           }
           break;
-        case INTERACTION_DRAGGING_SELECTION:
-          if (clicked_sample > state->selection_drag_start) {
-            audio_state->selection_start = state->selection_drag_start;
-            audio_state->selection_end = clicked_sample;
-          } else {
-            audio_state->selection_start = clicked_sample;
-            audio_state->selection_end = state->selection_drag_start;
+        case INTERACTION_DRAGGING_SELECTION: {
+          Sint64 start = clicked_frame;
+          Sint64 end = state->selection_drag_start;
+          if (clicked_frame > state->selection_drag_start) {
+            start = state->selection_drag_start;
+            end = clicked_frame;
           }
           // Ensure the selection is never zero-width.
-          if (audio_state->selection_start == audio_state->selection_end) {
-              audio_state->selection_end++;
+          if (start == end) {
+              end++;
           }
-          break;
+          audio_state_set_selection(audio_state, start, end);
+        } break;
         default:
           break;
         }
@@ -407,6 +512,9 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
   case SDL_EVENT_MOUSE_BUTTON_UP: {
     AppState *state = (AppState *)appstate;
     if (event->button.button == SDL_BUTTON_LEFT) {
+        if (state->waveform_interaction_state == INTERACTION_DRAGGING_PLAYHEAD) {
+            audio_state_end_scrub(state->audio_state);
+        }
         state->waveform_interaction_state = INTERACTION_NONE;
     }
     
@@ -447,16 +555,17 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
             float waveform_width = state->waveform_bbox.width;
             AudioState *audio_state = state->audio_state;
 
-            unsigned int visibleSamples = (unsigned int)(audio_state->sample->buffer_size / sizeof(float) /
-                                        state->waveform_view.zoom);
-            unsigned int maxStartSample =
-                (audio_state->sample->buffer_size / sizeof(float)) - visibleSamples;
-            unsigned int startSample = (unsigned int)(state->waveform_view.scroll * maxStartSample);
+            Sint64 visibleFrames = (Sint64)((double)audio_state->total_frames /
+                                            state->waveform_view.zoom);
+            Sint64 maxStartFrame =
+                audio_state->total_frames - visibleFrames;
+            Sint64 startFrame = (Sint64)(state->waveform_view.scroll * (double)maxStartFrame);
 
-            unsigned int clicked_sample =
-                startSample + (unsigned int)((click_x / waveform_width) * visibleSamples);
+            Sint64 clicked_frame =
+                startFrame + (Sint64)((double)(click_x / waveform_width) * visibleFrames);
 
-            audio_state->selection_end = clicked_sample;
+            audio_state_set_selection(audio_state, audio_state->selection_start,
+                                      clicked_frame);
         }
       } else {
         state->context_menu.x = (int)event->button.x;
@@ -528,6 +637,9 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
         handle_remove_markers((Clay_ElementId){0}, (Clay_PointerData){.state = CLAY_POINTER_DATA_PRESSED_THIS_FRAME}, (intptr_t)state);
       }
       break;
+    case SDLK_F3:
+      perf_hud_toggle(&state->perf_hud, &state->rendererData, state->audio_state);
+      break;
     }
   } break;
   default:
@@ -539,10 +651,14 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 
 SDL_AppResult SDL_AppIterate(void *appstate) {
   AppState *state = appstate;
-  state->is_tooltip_visible = false;
-  state->is_hovering_scrollbar_thumb = false;
+  PerfHud *hud = &state->perf_hud;
 
+  const Uint64 network_started = perf_hud_begin(hud);
   curl_manager_update(state->curl_manager);
+  perf_hud_end(hud, PERF_NETWORK, network_started);
+
+  // Seeks and selection changes from this iteration's events, coalesced
+  audio_state_sync_playback(state->audio_state);
 
   // Check CEP panel health when Premiere is detected
   ConnectedApp connected = (ConnectedApp)SDL_GetAtomicInt(&state->connected_app);
@@ -569,23 +685,51 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
     SDL_SetAtomicInt(&state->cep_health_status, CEP_HEALTH_UNCHECKED);
   }
 
-  Clay_BeginLayout();
-
-  build_ui(state);
-
-  Clay_RenderCommandArray render_commands = Clay_EndLayout();
-
-  Clay_ElementData waveform_element = Clay_GetElementData(CLAY_ID("WaveformDisplay"));
-  if (waveform_element.found) {
-    state->waveform_bbox = waveform_element.boundingBox;
+  // Skip the layout and render entirely unless an event came in or
+  // something drawn has changed since the last frame. Nothing is drawn
+  // while the window can't be seen; the pending redraw waits for it.
+  const RedrawSnapshot snapshot = take_redraw_snapshot(state);
+  const bool hidden = (SDL_GetWindowFlags(state->window) &
+                       (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED | SDL_WINDOW_OCCLUDED)) != 0;
+  if (!redraw_snapshot_equal(&snapshot, &state->last_drawn) &&
+      state->pending_frames == 0) {
+    state->pending_frames = 1;
+  }
+  // The playhead moves every frame while playing
+  if (snapshot.playback_state == PLAYBACK_PLAYING && state->pending_frames == 0) {
+    state->pending_frames = 1;
+  }
+  // Keep the overlay's audio figures fresh while nothing else is drawn
+  if (hud->visible && state->pending_frames == 0 &&
+      SDL_GetTicks() - state->last_frame_ticks >= IDLE_POLL_MS) {
+    state->pending_frames = 1;
   }
 
-  SDL_SetRenderDrawColor(state->rendererData.renderer, 0, 0, 0, 255);
-  SDL_RenderClear(state->rendererData.renderer);
-
-  SDL_Clay_RenderClayCommands(&state->rendererData, &render_commands);
+  // Events can arrive far faster than the display refreshes (mouse motion
+  // often does); they are all handled, but frames stay one refresh apart
+  const Uint64 frame_interval = active_frame_ms(state);
+  const bool frame_due = SDL_GetTicks() - state->last_frame_ticks >= frame_interval;
+  if (state->pending_frames > 0 && !hidden && frame_due) {
+    state->pending_frames--;
+    state->last_drawn = snapshot;
+    state->last_frame_ticks = SDL_GetTicks();
+    draw_frame(state);
+  }
 
-  SDL_RenderPresent(state->rendererData.renderer);
+  // Sleep until the next frame is due or an event arrives. Events are left
+  // queued; SDL hands them to SDL_AppEvent before the next iteration.
+  Sint32 timeout_ms;
+  if (hidden) {
+    timeout_ms = HIDDEN_POLL_MS;
+  } else if (state->pending_frames > 0 || is_animating(state, &snapshot)) {
+    const Uint64 elapsed = SDL_GetTicks() - state->last_frame_ticks;
+    timeout_ms = elapsed < frame_interval ? (Sint32)(frame_interval - elapsed) : 0;
+  } else {
+    timeout_ms = IDLE_POLL_MS;
+  }
+  if (timeout_ms > 0) {
+    SDL_WaitEventTimeout(NULL, timeout_ms);
+  }
 
   return SDL_APP_CONTINUE;
 }
@@ -602,12 +746,17 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result) {
   if (state) {
     SDL_SetAtomicInt(&state->should_stop_app_status_thread, 1);
     SDL_WaitThread(state->app_status_thread, NULL);
+    pcm_buffer_release(state->waveform_pcm);
     audio_state_destroy(state->audio_state);
 
     curl_manager_destroy(state->curl_manager);
     updater_destroy(state->updater_state);
 
     // Clean up SDL resources
+    // Cached text and tiles reference the fonts and the renderer
+    text_cache_destroy(state->rendererData.textCache);
+    FreeWaveformTiles(&state->rendererData.waveformTiles);
+    icon_atlas_destroy(&state->icons);
     if (state->rendererData.renderer)
       SDL_DestroyRenderer(state->rendererData.renderer);
 
@@ -624,22 +773,15 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result) {
     if (state->rendererData.textEngine)
       TTF_DestroyRendererTextEngine(state->rendererData.textEngine);
 
+    FreeWaveformGeometry(&state->rendererData.waveformGeometry);
+    FreeShapeBatch(&state->rendererData.shapes);
+
     // Free Clay memory buffer
     if (state->clayMemoryBuffer) {
       SDL_free(state->clayMemoryBuffer);
       state->clayMemoryBuffer = NULL;
     }
 
-    // Free icon surfaces
-    if (state->file_icon) SDL_DestroySurface(state->file_icon);
-    if (state->play_icon) SDL_DestroySurface(state->play_icon);
-    if (state->send_icon) SDL_DestroySurface(state->send_icon);
-    if (state->remove_icon) SDL_DestroySurface(state->remove_icon);
-    if (state->help_icon) SDL_DestroySurface(state->help_icon);
-    if (state->mark_in_icon) SDL_DestroySurface(state->mark_in_icon);
-    if (state->mark_out_icon) SDL_DestroySurface(state->mark_out_icon);
-    if (state->update_icon) SDL_DestroySurface(state->update_icon);
-
     SDL_free(state);
   }
 
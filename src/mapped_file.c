@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "mapped_file.h"
+#include <SDL3/SDL.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile* mapped_file_open(const char *path) {
+    int wide_len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+    if (wide_len <= 0) return NULL;
+    wchar_t *wide_path = SDL_malloc(wide_len * sizeof(wchar_t));
+    if (!wide_path) return NULL;
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, wide_path, wide_len);
+
+    HANDLE file = CreateFileW(wide_path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    SDL_free(wide_path);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return NULL;
+    }
+
+    MappedFile *mapped = SDL_calloc(1, sizeof(MappedFile));
+    if (!mapped) {
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return NULL;
+    }
+    mapped->data = data;
+    mapped->size = (size_t)size.QuadPart;
+    mapped->file = file;
+    mapped->mapping = mapping;
+    return mapped;
+}
+
+void mapped_file_close(MappedFile *file) {
+    if (!file) return;
+
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+    SDL_free(file);
+}
+
+#else
+
+MappedFile* mapped_file_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    MappedFile *mapped = SDL_calloc(1, sizeof(MappedFile));
+    if (!mapped) {
+        munmap(data, (size_t)st.st_size);
+        return NULL;
+    }
+    mapped->data = data;
+    mapped->size = (size_t)st.st_size;
+    return mapped;
+}
+
+void mapped_file_close(MappedFile *file) {
+    if (!file) return;
+
+    munmap((void *)file->data, file->size);
+    SDL_free(file);
+}
+
+#endif
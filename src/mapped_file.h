@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file
+typedef struct {
+    const void *data;
+    size_t size;
+#ifdef _WIN32
+    void *file;     // HANDLE
+    void *mapping;  // HANDLE
+#endif
+} MappedFile;
+
+// Map the file at `path` (UTF-8). Returns NULL if it can't be opened or is empty.
+MappedFile* mapped_file_open(const char *path);
+void mapped_file_close(MappedFile *file);
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "pcm_buffer.h"
+#include <string.h>
+
+PcmBuffer* pcm_buffer_create(Sint64 capacity_frames, int channels, int sample_rate) {
+    if (capacity_frames <= 0 || channels <= 0) return NULL;
+
+    PcmBuffer *buffer = SDL_calloc(1, sizeof(PcmBuffer));
+    if (!buffer) return NULL;
+
+    buffer->samples = SDL_malloc((size_t)capacity_frames * channels * sizeof(float));
+    if (!buffer->samples || !waveform_pyramid_init(&buffer->peaks, capacity_frames)) {
+        SDL_free(buffer->samples);
+        SDL_free(buffer);
+        return NULL;
+    }
+
+    buffer->capacity = capacity_frames;
+    buffer->channels = channels;
+    buffer->sample_rate = sample_rate;
+    atomic_s64_set(&buffer->frames, 0);
+    SDL_SetAtomicInt(&buffer->refcount, 1);
+
+    return buffer;
+}
+
+PcmBuffer* pcm_buffer_grow(PcmBuffer *buffer, Sint64 min_frames) {
+    if (!buffer) return NULL;
+    if (min_frames <= buffer->capacity) return buffer;
+
+    Sint64 new_capacity = buffer->capacity + buffer->capacity / 2;
+    if (new_capacity < min_frames) {
+        new_capacity = min_frames;
+    }
+
+    PcmBuffer *grown = pcm_buffer_create(new_capacity, buffer->channels,
+                                         buffer->sample_rate);
+    if (!grown) return NULL;
+
+    Sint64 frames = pcm_buffer_frames(buffer);
+    memcpy(grown->samples, buffer->samples,
+           (size_t)frames * buffer->channels * sizeof(float));
+    waveform_pyramid_copy(&grown->peaks, &buffer->peaks, frames);
+    atomic_s64_set(&grown->frames, frames);
+
+    pcm_buffer_release(buffer);
+    return grown;
+}
+
+PcmBuffer* pcm_buffer_retain(PcmBuffer *buffer) {
+    if (buffer) {
+        SDL_AtomicIncRef(&buffer->refcount);
+    }
+    return buffer;
+}
+
+void pcm_buffer_release(PcmBuffer *buffer) {
+    if (!buffer) return;
+
+    if (SDL_AtomicDecRef(&buffer->refcount)) {
+        waveform_pyramid_free(&buffer->peaks);
+        SDL_free(buffer->samples);
+        SDL_free(buffer);
+    }
+}
+
+Sint64 pcm_buffer_frames(PcmBuffer *buffer) {
+    if (!buffer) return 0;
+    return atomic_s64_get(&buffer->frames);
+}
+
+void pcm_buffer_publish(PcmBuffer *buffer, Sint64 frames) {
+    if (!buffer) return;
+    waveform_pyramid_update(&buffer->peaks, buffer->samples, buffer->channels, frames);
+    atomic_s64_set(&buffer->frames, frames);
+}
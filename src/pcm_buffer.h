@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PCM_BUFFER_H
+#define PCM_BUFFER_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+#include "atomic64.h"
+#include "waveform_pyramid.h"
+
+// Reference-counted block of decoded audio (interleaved float).
+//
+// One buffer is shared by the decoder, the waveform renderer, the beat
+// analysis and the audio callback. The first `frames` frames are
+// immutable once published: the decoder only appends past them, so
+// readers that hold a reference never need a lock to read that prefix.
+// When the decoder runs out of room, it moves into a bigger buffer and
+// drops its reference to the old one. Readers still holding the old
+// buffer keep a valid, slightly shorter view until they release it.
+//
+// The peak pyramid follows the same rule: it is extended before each
+// publish, so the entries covering the published frames are immutable too.
+typedef struct {
+    float *samples;
+    Sint64 capacity;        // Allocated size in frames
+    AtomicS64 frames;       // Frames published so far
+    int channels;
+    int sample_rate;
+    SDL_AtomicInt refcount;
+    WaveformPyramid peaks;  // Min/max/RMS of the published frames
+} PcmBuffer;
+
+// Allocate a buffer with room for capacity_frames frames and a refcount of 1
+PcmBuffer* pcm_buffer_create(Sint64 capacity_frames, int channels, int sample_rate);
+
+// Return a buffer with room for at least min_frames frames. The published
+// frames are copied over. The caller's reference to `buffer` is released
+// on success and kept on failure.
+PcmBuffer* pcm_buffer_grow(PcmBuffer *buffer, Sint64 min_frames);
+
+PcmBuffer* pcm_buffer_retain(PcmBuffer *buffer);
+void pcm_buffer_release(PcmBuffer *buffer);
+
+// Number of frames that can be read
+Sint64 pcm_buffer_frames(PcmBuffer *buffer);
+
+// Make `frames` frames visible to readers. Samples must be written first.
+// Also summarises the new frames into the peak pyramid.
+void pcm_buffer_publish(PcmBuffer *buffer, Sint64 frames);
+
+#endif // PCM_BUFFER_H
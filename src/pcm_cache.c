@@ -0,0 +1,634 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "pcm_cache.h"
+#include "app_paths.h"
+#include "fnv1a.h"
+#include "dsp/convert.h"
+#include <cJSON.h>
+#include <lz4.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PCM_CACHE_MAGIC 0x43504D41u  // "AMPC"
+#define PCM_CACHE_VERSION 2
+
+// Frames per compressed block. Blocks are independent, so an entry can be
+// streamed back without holding more than one compressed block in memory.
+#define PCM_CACHE_BLOCK_FRAMES 65536
+
+// SDL audio streams carry at most this many channels
+#define PCM_CACHE_MAX_CHANNELS 8
+
+// How a block's samples are packed before LZ4. Float audio barely
+// compresses as is, so:
+// - S16: every sample is a 16-bit value as convert_s16_to_f32 produces it
+//   (true for all blocks of 16-bit sources). Stored as 16-bit differences
+//   to the previous frame's sample in the same channel.
+// - F32: anything else, stored as is.
+// Either way the bytes are then split into planes by significance (all low
+// bytes, then the next ones), so the mostly constant high bytes and the
+// zero low mantissa bytes form long runs LZ4 can match.
+#define BLOCK_ENCODING_S16 1
+#define BLOCK_ENCODING_F32 2
+
+// Bytes hashed from each end of the source file
+#define HASH_SAMPLE_BYTES (64 * 1024)
+
+static bool get_cache_dir(char *out, size_t out_size) {
+    char *pref_path = SDL_GetPrefPath(UPDATER_ORG, UPDATER_APP);
+    if (!pref_path) return false;
+
+    snprintf(out, out_size, "%spcm_cache/", pref_path);
+    SDL_free(pref_path);
+
+    return SDL_CreateDirectory(out);
+}
+
+// --- LRU index ---
+//
+// index.json maps entry file names to their size and last use time:
+// {"entries": [{"file": "...", "bytes": 123, "last_used": 456}, ...]}
+//
+// Every thread that opens or stores an entry updates it: the current load,
+// cancelled loads still winding down and each batch worker. The
+// read-modify-write is serialised by one process-wide mutex, and the file
+// is replaced by rename so no reader (in this or another process) ever
+// sees it half written.
+
+#define INDEX_FILE_NAME "index.json"
+
+static SDL_SpinLock index_mutex_lock;
+static SDL_Mutex *index_mutex;
+
+// Created on first use and kept for the life of the process
+static SDL_Mutex* get_index_mutex(void) {
+    SDL_LockSpinlock(&index_mutex_lock);
+    if (!index_mutex) {
+        index_mutex = SDL_CreateMutex();
+    }
+    SDL_UnlockSpinlock(&index_mutex_lock);
+    return index_mutex;
+}
+
+static bool is_tmp_name(const char *name) {
+    const size_t length = strlen(name);
+    return length >= 4 && strcmp(name + length - 4, ".tmp") == 0;
+}
+
+typedef struct {
+    const char *dir;
+    cJSON *entries;
+} IndexScan;
+
+static SDL_EnumerationResult SDLCALL scan_entry(void *userdata, const char *dirname,
+                                                const char *fname) {
+    (void)dirname;
+    IndexScan *scan = userdata;
+    // Temporary files belong to writes in progress, which record themselves
+    if (strcmp(fname, INDEX_FILE_NAME) == 0 || is_tmp_name(fname)) {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    char entry_path[1024];
+    snprintf(entry_path, sizeof(entry_path), "%s%s", scan->dir, fname);
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(entry_path, &info) || info.type != SDL_PATHTYPE_FILE) {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    cJSON *entry = cJSON_CreateObject();
+    if (!entry) return SDL_ENUM_FAILURE;
+    cJSON_AddStringToObject(entry, "file", fname);
+    cJSON_AddNumberToObject(entry, "bytes", (double)info.size);
+    cJSON_AddNumberToObject(entry, "last_used", (double)info.modify_time);
+    cJSON_AddItemToArray(scan->entries, entry);
+    return SDL_ENUM_CONTINUE;
+}
+
+// Rebuild a lost or corrupt index from the entries on disk, using their
+// modification time as last use, so they stay under the size cap
+static cJSON* rebuild_index(const char *dir) {
+    cJSON *index = cJSON_CreateObject();
+    if (!index) return NULL;
+
+    IndexScan scan = {dir, cJSON_AddArrayToObject(index, "entries")};
+    if (!scan.entries || !SDL_EnumerateDirectory(dir, scan_entry, &scan)) {
+        printf("Warning: Could not rebuild PCM cache index: %s\n", SDL_GetError());
+    }
+    return index;
+}
+
+static cJSON* load_index(const char *dir) {
+    char index_path[1024];
+    snprintf(index_path, sizeof(index_path), "%s" INDEX_FILE_NAME, dir);
+
+    cJSON *index = NULL;
+    size_t size = 0;
+    char *buffer = SDL_LoadFile(index_path, &size);
+    if (buffer) {
+        index = cJSON_Parse(buffer);
+        SDL_free(buffer);
+    }
+
+    if (!index || !cJSON_IsArray(cJSON_GetObjectItem(index, "entries"))) {
+        cJSON_Delete(index);
+        index = rebuild_index(dir);
+    }
+    return index;
+}
+
+static void save_index(const char *dir, cJSON *index) {
+    char index_path[1024];
+    char tmp_path[1024];
+    snprintf(index_path, sizeof(index_path), "%s" INDEX_FILE_NAME, dir);
+    // Unique per thread, so another process saving at once can't interleave
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%" SDL_PRIu64 ".tmp", index_path,
+             (Uint64)SDL_GetCurrentThreadID());
+
+    char *json_string = cJSON_PrintUnformatted(index);
+    if (!json_string) return;
+
+    if (!SDL_SaveFile(tmp_path, json_string, strlen(json_string)) ||
+        !SDL_RenamePath(tmp_path, index_path)) {
+        printf("Warning: Could not write PCM cache index: %s\n", SDL_GetError());
+        SDL_RemovePath(tmp_path);
+    }
+    free(json_string);
+}
+
+// Mark `file_name` as just used. bytes < 0 keeps the recorded size; an
+// entry missing from the index is then added with its size on disk, or
+// not at all if the file is gone.
+static void touch_entry(const char *dir, cJSON *entries, const char *file_name, Sint64 bytes) {
+    SDL_Time now = 0;
+    SDL_GetCurrentTime(&now);
+
+    cJSON *entry;
+    cJSON_ArrayForEach(entry, entries) {
+        const cJSON *entry_file = cJSON_GetObjectItem(entry, "file");
+        if (cJSON_IsString(entry_file) && strcmp(entry_file->valuestring, file_name) == 0) {
+            break;
+        }
+    }
+
+    if (!entry && bytes < 0) {
+        char entry_path[1024];
+        snprintf(entry_path, sizeof(entry_path), "%s%s", dir, file_name);
+        SDL_PathInfo info;
+        if (!SDL_GetPathInfo(entry_path, &info) || info.type != SDL_PATHTYPE_FILE) {
+            return;
+        }
+        bytes = (Sint64)info.size;
+    }
+
+    if (!entry) {
+        entry = cJSON_CreateObject();
+        if (!entry) return;
+        cJSON_AddStringToObject(entry, "file", file_name);
+        cJSON_AddNumberToObject(entry, "bytes", 0);
+        cJSON_AddNumberToObject(entry, "last_used", 0);
+        cJSON_AddItemToArray(entries, entry);
+    }
+
+    if (bytes >= 0) {
+        cJSON_SetNumberValue(cJSON_GetObjectItem(entry, "bytes"), (double)bytes);
+    }
+    cJSON_SetNumberValue(cJSON_GetObjectItem(entry, "last_used"), (double)now);
+}
+
+// Delete least recently used entries until the cache fits its budget.
+// `keep_file` (the entry just written) is never evicted.
+static void evict_entries(const char *dir, cJSON *entries, const char *keep_file) {
+    double total = 0.0;
+    cJSON *entry;
+    cJSON_ArrayForEach(entry, entries) {
+        total += cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "bytes"));
+    }
+
+    while (total > (double)PCM_CACHE_MAX_BYTES) {
+        int oldest_index = -1;
+        double oldest_time = 0.0;
+        int i = 0;
+        cJSON_ArrayForEach(entry, entries) {
+            const cJSON *entry_file = cJSON_GetObjectItem(entry, "file");
+            double last_used = cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "last_used"));
+            bool keep = cJSON_IsString(entry_file) && strcmp(entry_file->valuestring, keep_file) == 0;
+            if (!keep && (oldest_index < 0 || last_used < oldest_time)) {
+                oldest_index = i;
+                oldest_time = last_used;
+            }
+            i++;
+        }
+        if (oldest_index < 0) break;
+
+        cJSON *victim = cJSON_DetachItemFromArray(entries, oldest_index);
+        const cJSON *victim_file = cJSON_GetObjectItem(victim, "file");
+        if (cJSON_IsString(victim_file)) {
+            char entry_path[1024];
+            snprintf(entry_path, sizeof(entry_path), "%s%s", dir, victim_file->valuestring);
+            SDL_RemovePath(entry_path);
+        }
+        total -= cJSON_GetNumberValue(cJSON_GetObjectItem(victim, "bytes"));
+        cJSON_Delete(victim);
+    }
+}
+
+bool pcm_cache_path(const char *file_name, char *out, size_t out_size) {
+    char dir[1024];
+    if (!get_cache_dir(dir, sizeof(dir))) return false;
+
+    snprintf(out, out_size, "%s%s", dir, file_name);
+    return true;
+}
+
+void pcm_cache_record(const char *file_name, Sint64 bytes) {
+    char dir[1024];
+    if (!get_cache_dir(dir, sizeof(dir))) return;
+
+    SDL_Mutex *mutex = get_index_mutex();
+    SDL_LockMutex(mutex);
+    cJSON *index = load_index(dir);
+    if (index) {
+        cJSON *entries = cJSON_GetObjectItem(index, "entries");
+        touch_entry(dir, entries, file_name, bytes);
+        if (bytes >= 0) {
+            evict_entries(dir, entries, file_name);
+        }
+        save_index(dir, index);
+        cJSON_Delete(index);
+    }
+    SDL_UnlockMutex(mutex);
+}
+
+// --- Keys ---
+
+bool pcm_cache_make_key(const char *path, PcmCacheKey *key) {
+    SDL_PathInfo info;
+    if (!path || !SDL_GetPathInfo(path, &info) || info.type != SDL_PATHTYPE_FILE) {
+        return false;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    if (!io) return false;
+
+    Uint8 *buffer = SDL_malloc(HASH_SAMPLE_BYTES);
+    if (!buffer) {
+        SDL_CloseIO(io);
+        return false;
+    }
+
+    // Hashing the head and tail catches files rewritten in place with the
+    // same size and timestamp, without reading the whole file on every open
+    Uint64 content_hash = FNV1A_OFFSET;
+    size_t read = SDL_ReadIO(io, buffer, HASH_SAMPLE_BYTES);
+    content_hash = fnv1a(content_hash, buffer, read);
+    if ((Sint64)info.size > HASH_SAMPLE_BYTES) {
+        Sint64 tail = (Sint64)info.size - HASH_SAMPLE_BYTES;
+        if (tail < HASH_SAMPLE_BYTES) {
+            tail = HASH_SAMPLE_BYTES;
+        }
+        if (SDL_SeekIO(io, tail, SDL_IO_SEEK_SET) >= 0) {
+            read = SDL_ReadIO(io, buffer, HASH_SAMPLE_BYTES);
+            content_hash = fnv1a(content_hash, buffer, read);
+        }
+    }
+    SDL_free(buffer);
+    SDL_CloseIO(io);
+
+    key->path = path;
+    key->size = (Sint64)info.size;
+    key->mtime = info.modify_time;
+    key->content_hash = content_hash;
+
+    Uint64 id = fnv1a(FNV1A_OFFSET, path, strlen(path));
+    id = fnv1a(id, &key->size, sizeof(key->size));
+    id = fnv1a(id, &key->mtime, sizeof(key->mtime));
+    id = fnv1a(id, &key->content_hash, sizeof(key->content_hash));
+    snprintf(key->id, sizeof(key->id), "%016" SDL_PRIx64, id);
+
+    return true;
+}
+
+// --- Entries ---
+//
+// Layout (little endian):
+//   u32 magic, u32 version, u32 channels, u32 sample_rate, s64 frames,
+//   s64 source size, s64 source mtime, u64 content hash,
+//   u32 path length, path bytes,
+//   then per block: u32 frames, u32 encoding, u32 compressed bytes, LZ4 data
+
+static bool write_header(SDL_IOStream *io, const PcmCacheKey *key,
+                         const PcmBuffer *pcm, Sint64 frames) {
+    Uint32 path_len = (Uint32)strlen(key->path);
+    return SDL_WriteU32LE(io, PCM_CACHE_MAGIC) &&
+           SDL_WriteU32LE(io, PCM_CACHE_VERSION) &&
+           SDL_WriteU32LE(io, (Uint32)pcm->channels) &&
+           SDL_WriteU32LE(io, (Uint32)pcm->sample_rate) &&
+           SDL_WriteS64LE(io, frames) &&
+           SDL_WriteS64LE(io, key->size) &&
+           SDL_WriteS64LE(io, key->mtime) &&
+           SDL_WriteU64LE(io, key->content_hash) &&
+           SDL_WriteU32LE(io, path_len) &&
+           SDL_WriteIO(io, key->path, path_len) == path_len;
+}
+
+static bool read_header(SDL_IOStream *io, const PcmCacheKey *key,
+                        PcmCacheReader *reader) {
+    Uint32 magic, version, channels, sample_rate, path_len;
+    Sint64 frames, size, mtime;
+    Uint64 content_hash;
+
+    if (!SDL_ReadU32LE(io, &magic) || magic != PCM_CACHE_MAGIC ||
+        !SDL_ReadU32LE(io, &version) || version != PCM_CACHE_VERSION ||
+        !SDL_ReadU32LE(io, &channels) || !SDL_ReadU32LE(io, &sample_rate) ||
+        !SDL_ReadS64LE(io, &frames) || !SDL_ReadS64LE(io, &size) ||
+        !SDL_ReadS64LE(io, &mtime) || !SDL_ReadU64LE(io, &content_hash) ||
+        !SDL_ReadU32LE(io, &path_len)) {
+        return false;
+    }
+
+    if (size != key->size || mtime != key->mtime ||
+        content_hash != key->content_hash || path_len != strlen(key->path) ||
+        channels == 0 || channels > PCM_CACHE_MAX_CHANNELS ||
+        sample_rate == 0 || frames <= 0) {
+        return false;
+    }
+
+    // The id is a hash, so make sure this entry really is for our path
+    char *path = SDL_malloc(path_len + 1);
+    if (!path) return false;
+    bool same_path = SDL_ReadIO(io, path, path_len) == path_len &&
+                     memcmp(path, key->path, path_len) == 0;
+    SDL_free(path);
+    if (!same_path) return false;
+
+    reader->channels = (int)channels;
+    reader->sample_rate = (int)sample_rate;
+    reader->frames = frames;
+    return true;
+}
+
+// --- Block packing ---
+
+// Split 16-bit values into a plane of low bytes followed by one of high bytes
+static void shuffle_s16(const Sint16 *in, Uint8 *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const Uint16 value = (Uint16)in[i];
+        out[i] = (Uint8)value;
+        out[count + i] = (Uint8)(value >> 8);
+    }
+}
+
+static void unshuffle_s16(const Uint8 *in, Sint16 *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (Sint16)(Uint16)(in[i] | in[count + i] << 8);
+    }
+}
+
+// Same for the bit patterns of floats, in four planes
+static void shuffle_f32(const float *in, Uint8 *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        Uint32 bits;
+        memcpy(&bits, &in[i], sizeof(bits));
+        out[i] = (Uint8)bits;
+        out[count + i] = (Uint8)(bits >> 8);
+        out[2 * count + i] = (Uint8)(bits >> 16);
+        out[3 * count + i] = (Uint8)(bits >> 24);
+    }
+}
+
+static void unshuffle_f32(const Uint8 *in, float *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const Uint32 bits = (Uint32)in[i] | (Uint32)in[count + i] << 8 |
+                            (Uint32)in[2 * count + i] << 16 |
+                            (Uint32)in[3 * count + i] << 24;
+        memcpy(&out[i], &bits, sizeof(bits));
+    }
+}
+
+// Replace each sample by its difference to the one a frame earlier, in
+// wrapping 16-bit arithmetic so it is exactly reversible
+static void delta_encode_s16(Sint16 *samples, size_t count, int channels) {
+    for (size_t i = count; i-- > (size_t)channels;) {
+        samples[i] = (Sint16)(Uint16)((Uint16)samples[i] - (Uint16)samples[i - channels]);
+    }
+}
+
+static void delta_decode_s16(Sint16 *samples, size_t count, int channels) {
+    for (size_t i = (size_t)channels; i < count; i++) {
+        samples[i] = (Sint16)(Uint16)((Uint16)samples[i] + (Uint16)samples[i - channels]);
+    }
+}
+
+// Recover the 16-bit samples behind `in`, if that is what they are. `check`
+// receives them converted back, which must reproduce `in` bit for bit.
+static bool to_exact_s16(const float *in, Sint16 *out, float *check, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const float scaled = in[i] * 32768.0f;
+        if (!(scaled >= -32768.0f && scaled <= 32767.0f)) {
+            return false;
+        }
+        out[i] = (Sint16)scaled;
+    }
+    convert_s16_to_f32(out, check, count);
+    return memcmp(in, check, count * sizeof(float)) == 0;
+}
+
+PcmCacheReader* pcm_cache_open(const PcmCacheKey *key) {
+    if (!key) return NULL;
+
+    char file_name[32];
+    char entry_path[1024];
+    snprintf(file_name, sizeof(file_name), "%s.pcm", key->id);
+    if (!pcm_cache_path(file_name, entry_path, sizeof(entry_path))) return NULL;
+
+    SDL_IOStream *io = SDL_IOFromFile(entry_path, "rb");
+    if (!io) return NULL;
+
+    PcmCacheReader *reader = SDL_calloc(1, sizeof(PcmCacheReader));
+    if (!reader) {
+        SDL_CloseIO(io);
+        return NULL;
+    }
+
+    if (!read_header(io, key, reader)) {
+        // Stale or corrupt; the next store overwrites it
+        SDL_CloseIO(io);
+        SDL_free(reader);
+        return NULL;
+    }
+    reader->io = io;
+
+    // Scratch for the largest block the entry can hold
+    const size_t block_samples = (size_t)PCM_CACHE_BLOCK_FRAMES * reader->channels;
+    reader->compressed = SDL_malloc((size_t)LZ4_compressBound((int)(block_samples * sizeof(float))));
+    reader->packed = SDL_malloc(block_samples * sizeof(float));
+    reader->samples16 = SDL_malloc(block_samples * sizeof(Sint16));
+    if (!reader->compressed || !reader->packed || !reader->samples16) {
+        pcm_cache_close(reader);
+        return NULL;
+    }
+
+    pcm_cache_record(file_name, -1);
+    return reader;
+}
+
+Sint64 pcm_cache_read(PcmCacheReader *reader, float *dst, Sint64 max_frames) {
+    if (!reader || reader->frames_read >= reader->frames) return 0;
+
+    Uint32 block_frames, encoding, compressed_bytes;
+    if (!SDL_ReadU32LE(reader->io, &block_frames) ||
+        !SDL_ReadU32LE(reader->io, &encoding) ||
+        !SDL_ReadU32LE(reader->io, &compressed_bytes)) {
+        return -1;
+    }
+
+    const Sint64 frames = (Sint64)block_frames;
+    if (frames == 0 || frames > PCM_CACHE_BLOCK_FRAMES || frames > max_frames ||
+        frames > reader->frames - reader->frames_read) {
+        return -1;
+    }
+
+    const size_t count = (size_t)frames * reader->channels;
+    size_t packed_bytes;
+    if (encoding == BLOCK_ENCODING_S16) {
+        packed_bytes = count * sizeof(Sint16);
+    } else if (encoding == BLOCK_ENCODING_F32) {
+        packed_bytes = count * sizeof(float);
+    } else {
+        return -1;
+    }
+
+    // The scratch buffer fits the bound of the largest valid block, so
+    // anything bigger is damage, not a reason to allocate more
+    if (compressed_bytes == 0 ||
+        compressed_bytes > (Uint32)LZ4_compressBound((int)packed_bytes) ||
+        SDL_ReadIO(reader->io, reader->compressed, compressed_bytes) != compressed_bytes) {
+        return -1;
+    }
+
+    int decompressed = LZ4_decompress_safe(reader->compressed, reader->packed,
+                                           (int)compressed_bytes, (int)packed_bytes);
+    if (decompressed != (int)packed_bytes) {
+        return -1;
+    }
+
+    if (encoding == BLOCK_ENCODING_S16) {
+        unshuffle_s16((const Uint8 *)reader->packed, reader->samples16, count);
+        delta_decode_s16(reader->samples16, count, reader->channels);
+        convert_s16_to_f32(reader->samples16, dst, count);
+    } else {
+        unshuffle_f32((const Uint8 *)reader->packed, dst, count);
+    }
+
+    reader->frames_read += frames;
+    return frames;
+}
+
+void pcm_cache_close(PcmCacheReader *reader) {
+    if (!reader) return;
+
+    SDL_CloseIO(reader->io);
+    SDL_free(reader->compressed);
+    SDL_free(reader->packed);
+    SDL_free(reader->samples16);
+    SDL_free(reader);
+}
+
+bool pcm_cache_store(const PcmCacheKey *key, PcmBuffer *pcm, SDL_AtomicInt *cancel) {
+    if (!key || !pcm) return false;
+
+    const Sint64 frames = pcm_buffer_frames(pcm);
+    if (frames <= 0) return false;
+
+    // Write to a temporary name so a crash never leaves a truncated entry,
+    // unique per thread in case a cancelled load is storing the same file
+    char file_name[32];
+    char tmp_path[1024];
+    char entry_path[1024];
+    snprintf(file_name, sizeof(file_name), "%s.pcm", key->id);
+    if (!pcm_cache_path(file_name, entry_path, sizeof(entry_path))) return false;
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%" SDL_PRIu64 ".tmp", entry_path,
+             (Uint64)SDL_GetCurrentThreadID());
+
+    SDL_IOStream *io = SDL_IOFromFile(tmp_path, "wb");
+    if (!io) return false;
+
+    const int channels = pcm->channels;
+    const size_t block_samples = (size_t)PCM_CACHE_BLOCK_FRAMES * channels;
+    const int bound = LZ4_compressBound((int)(block_samples * sizeof(float)));
+    char *compressed = SDL_malloc((size_t)bound);
+    Uint8 *packed = SDL_malloc(block_samples * sizeof(float));
+    Sint16 *samples16 = SDL_malloc(block_samples * sizeof(Sint16));
+    float *check = SDL_malloc(block_samples * sizeof(float));
+
+    bool ok = compressed && packed && samples16 && check &&
+              channels <= PCM_CACHE_MAX_CHANNELS && write_header(io, key, pcm, frames);
+    for (Sint64 start = 0; ok && start < frames; start += PCM_CACHE_BLOCK_FRAMES) {
+        if (cancel && SDL_GetAtomicInt(cancel)) {
+            ok = false;
+            break;
+        }
+
+        Sint64 block_frames = frames - start;
+        if (block_frames > PCM_CACHE_BLOCK_FRAMES) {
+            block_frames = PCM_CACHE_BLOCK_FRAMES;
+        }
+
+        const float *samples = pcm->samples + start * channels;
+        const size_t count = (size_t)block_frames * channels;
+        Uint32 encoding;
+        int packed_bytes;
+        if (to_exact_s16(samples, samples16, check, count)) {
+            delta_encode_s16(samples16, count, channels);
+            shuffle_s16(samples16, packed, count);
+            encoding = BLOCK_ENCODING_S16;
+            packed_bytes = (int)(count * sizeof(Sint16));
+        } else {
+            shuffle_f32(samples, packed, count);
+            encoding = BLOCK_ENCODING_F32;
+            packed_bytes = (int)(count * sizeof(float));
+        }
+
+        const int compressed_bytes = LZ4_compress_default(
+            (const char *)packed, compressed, packed_bytes, bound);
+
+        ok = compressed_bytes > 0 &&
+             SDL_WriteU32LE(io, (Uint32)block_frames) &&
+             SDL_WriteU32LE(io, encoding) &&
+             SDL_WriteU32LE(io, (Uint32)compressed_bytes) &&
+             SDL_WriteIO(io, compressed, (size_t)compressed_bytes) == (size_t)compressed_bytes;
+    }
+
+    const Sint64 entry_bytes = SDL_TellIO(io);
+    ok = SDL_CloseIO(io) && ok;
+    SDL_free(compressed);
+    SDL_free(packed);
+    SDL_free(samples16);
+    SDL_free(check);
+
+    if (!ok || !SDL_RenamePath(tmp_path, entry_path)) {
+        SDL_RemovePath(tmp_path);
+        return false;
+    }
+
+    pcm_cache_record(file_name, entry_bytes);
+    return true;
+}
@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PCM_CACHE_H
+#define PCM_CACHE_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+#include "pcm_buffer.h"
+
+// On-disk cache of decoded audio, so reopening a file skips decoding.
+//
+// Entries live under the app's pref path, LZ4-compressed in independent
+// blocks so they can be streamed back into a PcmBuffer. Audio decoded from
+// 16-bit sources is stored as 16-bit deltas rather than floats, which
+// roughly halves the size before compression. The cache is capped
+// at PCM_CACHE_MAX_BYTES; the least recently used entries are evicted first.
+// Any thread may use it: readers and writers of one entry each get their
+// own stream, and updates to the shared LRU index are serialised.
+
+#define PCM_CACHE_MAX_BYTES ((Sint64)2 * 1024 * 1024 * 1024)
+
+// Identity of a source file. An entry only matches if path, size,
+// modification time and content hash are all unchanged.
+typedef struct {
+    const char *path;       // Borrowed, must outlive the key
+    Sint64 size;
+    SDL_Time mtime;
+    Uint64 content_hash;    // Hash of the first and last 64 KiB of the file
+    char id[17];            // Hex name of the cache entry
+} PcmCacheKey;
+
+typedef struct {
+    SDL_IOStream *io;
+    int channels;
+    int sample_rate;
+    Sint64 frames;          // Total frames in the entry
+    Sint64 frames_read;
+    void *compressed;       // Scratch for one block: as stored,
+    void *packed;           // decompressed,
+    Sint16 *samples16;      // and unpacked, for 16-bit blocks
+} PcmCacheReader;
+
+// Fill `key` for the file at `path`. Returns false if the file can't be read.
+bool pcm_cache_make_key(const char *path, PcmCacheKey *key);
+
+// Open the entry for `key`, or return NULL if there is none
+PcmCacheReader* pcm_cache_open(const PcmCacheKey *key);
+
+// Decode the next block into `dst`, which has room for `max_frames` frames.
+// Returns the number of frames written, 0 at the end, or -1 on error.
+Sint64 pcm_cache_read(PcmCacheReader *reader, float *dst, Sint64 max_frames);
+
+void pcm_cache_close(PcmCacheReader *reader);
+
+// Path of `file_name` inside the cache directory. Other per-file caches
+// (see analysis_cache.h) keep their entries here too, so they share the
+// size budget and LRU eviction.
+bool pcm_cache_path(const char *file_name, char *out, size_t out_size);
+
+// Record that `file_name` was just used. Pass its size in bytes after
+// writing it (which may evict other entries), or -1 when only reading.
+void pcm_cache_record(const char *file_name, Sint64 bytes);
+
+// Write the published frames of `pcm` as the entry for `key`, then evict old
+// entries. Gives up early, leaving no entry behind, if `cancel` becomes set.
+bool pcm_cache_store(const PcmCacheKey *key, PcmBuffer *pcm, SDL_AtomicInt *cancel);
+
+#endif // PCM_CACHE_H
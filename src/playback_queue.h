@@ -0,0 +1,86 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PLAYBACK_QUEUE_H
+#define PLAYBACK_QUEUE_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+
+// Slots in the queue; a power of two
+#define PLAYBACK_QUEUE_SIZE 256
+
+typedef enum {
+    PLAYBACK_CMD_SEEK,      // frame = new position
+    PLAYBACK_CMD_SET_LOOP,  // frame..end = loop region
+    PLAYBACK_CMD_PLAY,
+    PLAYBACK_CMD_PAUSE,
+    PLAYBACK_CMD_STOP,
+    PLAYBACK_CMD_SCRUB_BEGIN, // frame = pointer position
+    PLAYBACK_CMD_SCRUB_END    // frame = where playback continues
+} PlaybackCommandType;
+
+typedef struct {
+    PlaybackCommandType type;
+    Sint64 frame;
+    Sint64 end;
+    Uint32 serial;          // SEEK, SCRUB_END: matched against AudioState.applied_seek_serial
+                            // SCRUB_BEGIN: reported back in finished_scrub_serial
+} PlaybackCommand;
+
+// Single-producer, single-consumer ring of transport commands from the UI
+// thread to the audio callback. Neither side locks or allocates. Each
+// index is written by one side only; the SDL atomics order the slot
+// contents before the index that publishes them.
+typedef struct {
+    PlaybackCommand slots[PLAYBACK_QUEUE_SIZE];
+    SDL_AtomicInt head;     // Next slot to write, producer only
+    SDL_AtomicInt tail;     // Next slot to read, consumer only
+} PlaybackQueue;
+
+// Empty the queue. Only while no consumer can be running.
+static inline void playback_queue_reset(PlaybackQueue *queue) {
+    SDL_SetAtomicInt(&queue->head, 0);
+    SDL_SetAtomicInt(&queue->tail, 0);
+}
+
+// Returns false, dropping nothing, if the queue is full
+static inline bool playback_queue_push(PlaybackQueue *queue, const PlaybackCommand *command) {
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&queue->head);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&queue->tail);
+    if (head - tail >= PLAYBACK_QUEUE_SIZE) {
+        return false;
+    }
+    queue->slots[head & (PLAYBACK_QUEUE_SIZE - 1)] = *command;
+    SDL_SetAtomicInt(&queue->head, (int)(head + 1));
+    return true;
+}
+
+// Returns false if the queue is empty
+static inline bool playback_queue_pop(PlaybackQueue *queue, PlaybackCommand *command) {
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&queue->tail);
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&queue->head);
+    if (tail == head) {
+        return false;
+    }
+    *command = queue->slots[tail & (PLAYBACK_QUEUE_SIZE - 1)];
+    SDL_SetAtomicInt(&queue->tail, (int)(tail + 1));
+    return true;
+}
+
+#endif // PLAYBACK_QUEUE_H
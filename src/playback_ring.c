@@ -0,0 +1,40 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "playback_ring.h"
+
+bool playback_ring_init(PlaybackRing *ring, int channels) {
+    SDL_zerop(ring);
+    if (channels <= 0) return false;
+
+    const size_t block_samples = (size_t)PLAYBACK_RING_BLOCK_FRAMES * channels;
+    ring->samples = SDL_malloc(PLAYBACK_RING_BLOCKS * block_samples * sizeof(float));
+    if (!ring->samples) return false;
+
+    ring->channels = channels;
+    for (int i = 0; i < PLAYBACK_RING_BLOCKS; i++) {
+        ring->blocks[i].samples = ring->samples + i * block_samples;
+    }
+    playback_ring_reset(ring);
+    return true;
+}
+
+void playback_ring_free(PlaybackRing *ring) {
+    SDL_free(ring->samples);
+    SDL_zerop(ring);
+}
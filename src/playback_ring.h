@@ -0,0 +1,92 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PLAYBACK_RING_H
+#define PLAYBACK_RING_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+
+// Frames per block
+#define PLAYBACK_RING_BLOCK_FRAMES 1024
+
+// Blocks in the ring; a power of two. About 0.7 s at 48 kHz.
+#define PLAYBACK_RING_BLOCKS 32
+
+// A run of consecutive timeline frames, interleaved
+typedef struct {
+    float *samples;     // Room for PLAYBACK_RING_BLOCK_FRAMES frames
+    Sint64 frame;       // Timeline frame of the first one
+    int frames;         // Frames filled
+    int generation;     // Feed request they were read for
+} PlaybackBlock;
+
+// Single-producer, single-consumer ring of audio blocks, from the playback
+// feeder thread to the audio callback. Laid out like PlaybackQueue: each
+// index is written by one side only, and the SDL atomics order a block's
+// contents before the index that publishes it. The samples are allocated
+// once, so its size doesn't depend on the file's length.
+typedef struct {
+    PlaybackBlock blocks[PLAYBACK_RING_BLOCKS];
+    float *samples;
+    int channels;
+    SDL_AtomicInt head;     // Next block to write, producer only
+    SDL_AtomicInt tail;     // Next block to read, consumer only
+} PlaybackRing;
+
+// Allocate the blocks for `channels` channels. Returns false on failure.
+bool playback_ring_init(PlaybackRing *ring, int channels);
+void playback_ring_free(PlaybackRing *ring);
+
+// Empty the ring. Only while neither side can be running.
+static inline void playback_ring_reset(PlaybackRing *ring) {
+    SDL_SetAtomicInt(&ring->head, 0);
+    SDL_SetAtomicInt(&ring->tail, 0);
+}
+
+// The block to fill next, or NULL if the ring is full. It's handed to the
+// consumer by playback_ring_push().
+static inline PlaybackBlock* playback_ring_back(PlaybackRing *ring) {
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&ring->head);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&ring->tail);
+    if (!ring->samples || head - tail >= PLAYBACK_RING_BLOCKS) {
+        return NULL;
+    }
+    return &ring->blocks[head & (PLAYBACK_RING_BLOCKS - 1)];
+}
+
+static inline void playback_ring_push(PlaybackRing *ring) {
+    SDL_AddAtomicInt(&ring->head, 1);
+}
+
+// The oldest block, or NULL if the ring is empty. It stays valid until
+// playback_ring_pop().
+static inline PlaybackBlock* playback_ring_front(PlaybackRing *ring) {
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&ring->tail);
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&ring->head);
+    if (tail == head) {
+        return NULL;
+    }
+    return &ring->blocks[tail & (PLAYBACK_RING_BLOCKS - 1)];
+}
+
+static inline void playback_ring_pop(PlaybackRing *ring) {
+    SDL_AddAtomicInt(&ring->tail, 1);
+}
+
+#endif // PLAYBACK_RING_H
@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "text_cache.h"
+#include "fnv1a.h"
+#include <string.h>
+
+struct TextCacheEntry {
+    TextCacheEntry *next;
+    Uint64 hash;
+    TTF_Font *font;
+    SDL_Color color;
+    char *chars;
+    int length;
+    TTF_Text *text;         // Shaped on first draw
+    int width, height;
+    bool measured;
+    Uint32 last_used;       // Generation it was last looked up in
+    Uint32 frames_used;     // Generations it was looked up in
+};
+
+static Uint64 entry_hash(TTF_Font *font, const char *chars, int length, SDL_Color color) {
+    Uint64 hash = fnv1a(FNV1A_OFFSET, &font, sizeof(font));
+    hash = fnv1a(hash, &color, sizeof(color));
+    return fnv1a(hash, chars, (size_t)length);
+}
+
+static void free_entry(TextCacheEntry *entry) {
+    if (entry->text) {
+        TTF_DestroyText(entry->text);
+    }
+    SDL_free(entry->chars);
+    SDL_free(entry);
+}
+
+static TextCacheEntry* lookup(TextCache *cache, TTF_Font *font, const char *chars, int length,
+                              SDL_Color color) {
+    const Uint64 hash = entry_hash(font, chars, length, color);
+    TextCacheEntry **bucket = &cache->buckets[hash % TEXT_CACHE_BUCKETS];
+
+    TextCacheEntry *entry = *bucket;
+    while (entry && !(entry->hash == hash && entry->font == font && entry->length == length &&
+                      memcmp(&entry->color, &color, sizeof(color)) == 0 &&
+                      memcmp(entry->chars, chars, (size_t)length) == 0)) {
+        entry = entry->next;
+    }
+
+    if (!entry) {
+        entry = SDL_calloc(1, sizeof(TextCacheEntry));
+        if (!entry) return NULL;
+        entry->chars = SDL_malloc((size_t)length + 1);
+        if (!entry->chars) {
+            SDL_free(entry);
+            return NULL;
+        }
+        memcpy(entry->chars, chars, (size_t)length);
+        entry->chars[length] = '\0';
+        entry->length = length;
+        entry->hash = hash;
+        entry->font = font;
+        entry->color = color;
+        entry->last_used = cache->generation - 1;
+        entry->next = *bucket;
+        *bucket = entry;
+        cache->count++;
+    }
+
+    if (entry->last_used != cache->generation) {
+        entry->last_used = cache->generation;
+        entry->frames_used++;
+    }
+    return entry;
+}
+
+TextCache* text_cache_create(TTF_TextEngine *engine) {
+    TextCache *cache = SDL_calloc(1, sizeof(TextCache));
+    if (!cache) return NULL;
+    cache->engine = engine;
+    return cache;
+}
+
+void text_cache_destroy(TextCache *cache) {
+    if (!cache) return;
+    for (int i = 0; i < TEXT_CACHE_BUCKETS; i++) {
+        TextCacheEntry *entry = cache->buckets[i];
+        while (entry) {
+            TextCacheEntry *next = entry->next;
+            free_entry(entry);
+            entry = next;
+        }
+    }
+    SDL_free(cache);
+}
+
+bool text_cache_measure(TextCache *cache, TTF_Font *font, const char *chars, int length,
+                        SDL_Color color, int *width, int *height) {
+    TextCacheEntry *entry = lookup(cache, font, chars, length, color);
+    if (!entry) {
+        return TTF_GetStringSize(font, chars, (size_t)length, width, height);
+    }
+
+    if (!entry->measured) {
+        if (!TTF_GetStringSize(font, entry->chars, (size_t)length, &entry->width, &entry->height)) {
+            return false;
+        }
+        entry->measured = true;
+    }
+    *width = entry->width;
+    *height = entry->height;
+    return true;
+}
+
+TTF_Text* text_cache_get(TextCache *cache, TTF_Font *font, const char *chars, int length,
+                         SDL_Color color) {
+    TextCacheEntry *entry = lookup(cache, font, chars, length, color);
+    if (!entry) return NULL;
+
+    if (!entry->text) {
+        entry->text = TTF_CreateText(cache->engine, font, entry->chars, (size_t)length);
+        if (!entry->text) return NULL;
+        TTF_SetTextColor(entry->text, color.r, color.g, color.b, color.a);
+    }
+    return entry->text;
+}
+
+void text_cache_end_frame(TextCache *cache) {
+    // Over budget, pinned labels that are off screen go too
+    const bool over_budget = cache->count > TEXT_CACHE_BUDGET;
+
+    for (int i = 0; i < TEXT_CACHE_BUCKETS; i++) {
+        TextCacheEntry **link = &cache->buckets[i];
+        while (*link) {
+            TextCacheEntry *entry = *link;
+            const Uint32 idle = cache->generation - entry->last_used;
+            const bool pinned = entry->frames_used >= TEXT_CACHE_PIN_FRAMES && !over_budget;
+            if (idle >= TEXT_CACHE_MAX_IDLE && !pinned) {
+                *link = entry->next;
+                free_entry(entry);
+                cache->count--;
+            } else {
+                link = &entry->next;
+            }
+        }
+    }
+
+    cache->generation++;
+}
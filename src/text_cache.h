@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+// Shaped text and measurements, keyed by (font, string, color), so labels
+// that appear frame after frame are measured and shaped once.
+//
+// Each drawn frame is one generation. An entry seen in only a few frames
+// is dropped once it goes unused for TEXT_CACHE_MAX_IDLE generations, which
+// keeps changing strings (progress, times) from piling up. An entry seen
+// in TEXT_CACHE_PIN_FRAMES frames or more counts as a static label and
+// stays until the cache outgrows TEXT_CACHE_BUDGET entries.
+#define TEXT_CACHE_BUCKETS 256
+#define TEXT_CACHE_MAX_IDLE 2
+#define TEXT_CACHE_PIN_FRAMES 8
+#define TEXT_CACHE_BUDGET 1024
+
+typedef struct TextCacheEntry TextCacheEntry;
+
+typedef struct {
+    TextCacheEntry *buckets[TEXT_CACHE_BUCKETS];
+    TTF_TextEngine *engine;
+    Uint32 generation;
+    int count;
+} TextCache;
+
+// The engine is used to shape text for drawing; measuring doesn't need it
+TextCache* text_cache_create(TTF_TextEngine *engine);
+void text_cache_destroy(TextCache *cache);
+
+// Size of `chars` (length bytes, not NUL-terminated) in `font`
+bool text_cache_measure(TextCache *cache, TTF_Font *font, const char *chars, int length,
+                        SDL_Color color, int *width, int *height);
+
+// Shaped text ready for TTF_DrawRendererText, owned by the cache. Valid
+// until the next text_cache_end_frame.
+TTF_Text* text_cache_get(TextCache *cache, TTF_Font *font, const char *chars, int length,
+                         SDL_Color color);
+
+// Evict stale entries and start the next generation. Call once per drawn frame.
+void text_cache_end_frame(TextCache *cache);
+
+#endif // TEXT_CACHE_H
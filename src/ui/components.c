@@ -26,7 +26,7 @@
 #define APP_VERSION "0.0.0"
 #endif
 
-void headerButton(Clay_ElementId buttonId, Clay_ElementId iconId, SDL_Surface *icon,
+void headerButton(Clay_ElementId buttonId, Clay_ElementId iconId, AtlasImage *icon,
                   const char *tooltip,
                   void (*callback)(Clay_ElementId, Clay_PointerData, intptr_t),
                   intptr_t userData) {
@@ -50,7 +50,7 @@ void headerButton(Clay_ElementId buttonId, Clay_ElementId iconId, SDL_Surface *i
       }
     }
     CLAY(iconId, {
-          .layout = {.sizing = {.width = CLAY_SIZING_FIXED(50),
+          .layout = {.sizing = {.width = CLAY_SIZING_FIXED(ICON_SIZE),
                                 .height = CLAY_SIZING_GROW(0)}},
           .aspectRatio = {.aspectRatio = 1.0f},
           .image = {
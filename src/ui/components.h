@@ -23,7 +23,7 @@
 #include "../app_state.h"
 
 // Header button component
-void headerButton(Clay_ElementId buttonId, Clay_ElementId iconId, SDL_Surface *icon,
+void headerButton(Clay_ElementId buttonId, Clay_ElementId iconId, AtlasImage *icon,
                   const char *tooltip,
                   void (*callback)(Clay_ElementId, Clay_PointerData, intptr_t),
                   intptr_t userData);
@@ -20,6 +20,7 @@
 #include "../connections/premiere_pro.h"
 #include "../connections/after_effects.h"
 #include "../connections/resolve.h"
+#include "../beat_index.h"
 #include "../../libs/SDL_sound/include/SDL3_sound/SDL_sound.h"
 #include "../../libs/tinyfiledialogs/tinyfiledialogs.h"
 #include <math.h>
@@ -140,7 +141,8 @@ void handle_mark_in(Clay_ElementId elementId, Clay_PointerData pointerData,
     AppState *app_state = (AppState *)userData;
     AudioState *audio_state = app_state->audio_state;
     if (audio_state->status == STATUS_COMPLETED) {
-      audio_state->selection_start = audio_state_get_playback_position(audio_state);
+      audio_state_set_selection(audio_state, audio_state_get_playback_position(audio_state),
+                                audio_state->selection_end);
     }
   }
 }
@@ -152,7 +154,8 @@ void handle_mark_out(Clay_ElementId elementId, Clay_PointerData pointerData,
     AppState *app_state = (AppState *)userData;
     AudioState *audio_state = app_state->audio_state;
     if (audio_state->status == STATUS_COMPLETED) {
-      audio_state->selection_end = audio_state_get_playback_position(audio_state);
+      audio_state_set_selection(audio_state, audio_state->selection_start,
+                                audio_state_get_playback_position(audio_state));
     }
   }
 }
@@ -165,16 +168,17 @@ void handle_send_markers(Clay_ElementId elementId, Clay_PointerData pointerData,
     AudioState *audio_state = app_state->audio_state;
 
     if (audio_state->status == STATUS_COMPLETED) {
-      int markers_in_selection_count = 0;
-      for (int i = 0; i < audio_state->beat_count; i++) {
-        if (audio_state->beat_positions[i] >= audio_state->selection_start &&
-            audio_state->beat_positions[i] <= audio_state->selection_end) {
-          markers_in_selection_count++;
-        }
-      }
+      // Beats are sorted, so the selection is one contiguous run of them
+      const int first_marker = beat_index_lower_bound(
+          audio_state->beat_positions, audio_state->beat_count,
+          audio_state->selection_start);
+      const int end_marker = beat_index_upper_bound(
+          audio_state->beat_positions, audio_state->beat_count,
+          audio_state->selection_end);
+      const int markers_in_selection_count = end_marker - first_marker;
 
       // Handle edge case: no markers in selection
-      if (markers_in_selection_count == 0) {
+      if (markers_in_selection_count <= 0) {
         return;
       }
 
@@ -183,15 +187,10 @@ void handle_send_markers(Clay_ElementId elementId, Clay_PointerData pointerData,
       if (!beats_in_seconds) {
         return;
       }
-      int current_marker = 0;
-      for (int i = 0; i < audio_state->beat_count; i++) {
-        if (audio_state->beat_positions[i] >= audio_state->selection_start &&
-            audio_state->beat_positions[i] <= audio_state->selection_end) {
-          beats_in_seconds[current_marker] =
-              (double)(audio_state->beat_positions[i] - audio_state->selection_start) /
-                (audio_state->sample->actual.rate * audio_state->sample->actual.channels);
-          current_marker++;
-        }
+      for (int i = first_marker; i < end_marker; i++) {
+        beats_in_seconds[i - first_marker] = audio_state_frames_to_seconds(
+            audio_state,
+            audio_state->beat_positions[i] - audio_state->selection_start);
       }
 
       switch ((ConnectedApp)SDL_GetAtomicInt(&app_state->connected_app)) {
@@ -266,31 +265,32 @@ void handle_waveform_interaction(Clay_ElementId elementId,
     zoom = 1.0f;
   }
 
-  unsigned int totalSamples = (unsigned int)(audio_state->sample->buffer_size / sizeof(float));
-  if (totalSamples == 0) {
+  Sint64 totalFrames = audio_state->total_frames;
+  if (totalFrames <= 0) {
     return;
   }
 
-  unsigned int visibleSamples = (unsigned int)(totalSamples / zoom);
-  // Clamp visibleSamples to valid range [1, totalSamples]
-  if (visibleSamples == 0) {
-    visibleSamples = 1;
+  Sint64 visibleFrames = (Sint64)((double)totalFrames / zoom);
+  // Clamp visibleFrames to valid range [1, totalFrames]
+  if (visibleFrames <= 0) {
+    visibleFrames = 1;
   }
-  if (visibleSamples > totalSamples) {
-    visibleSamples = totalSamples;
+  if (visibleFrames > totalFrames) {
+    visibleFrames = totalFrames;
   }
 
-  // Guard against underflow: if visibleSamples >= totalSamples, no scrolling possible
-  unsigned int maxStartSample = 0;
-  if (visibleSamples < totalSamples) {
-    maxStartSample = totalSamples - visibleSamples;
+  // If visibleFrames >= totalFrames, no scrolling possible
+  Sint64 maxStartFrame = totalFrames - visibleFrames;
+  Sint64 startFrame = (Sint64)(app_state->waveform_view.scroll * (double)maxStartFrame);
+  if (startFrame > maxStartFrame) {
+    startFrame = maxStartFrame;
   }
-  unsigned int startSample = (unsigned int)(app_state->waveform_view.scroll * maxStartSample);
-  if (startSample > maxStartSample) {
-    startSample = maxStartSample;
+  if (startFrame < 0) {
+    startFrame = 0;
   }
+  const Sint64 endFrame = startFrame + visibleFrames;
 
-  // Clamp click_x to [0, waveform_width] to avoid out-of-bounds sample calculation
+  // Clamp click_x to [0, waveform_width] to avoid out-of-bounds frame calculation
   float click_x = pointerData.position.x - waveform_element.boundingBox.x;
   if (click_x < 0.0f) {
     click_x = 0.0f;
@@ -305,20 +305,20 @@ void handle_waveform_interaction(Clay_ElementId elementId,
   // Calculate screen x for markers
   float start_marker_x = -1.0f;
   if (audio_state->selection_start > 0) {
-    if (audio_state->selection_start >= startSample &&
-        audio_state->selection_start < startSample + visibleSamples) {
+    if (audio_state->selection_start >= startFrame &&
+        audio_state->selection_start < endFrame) {
       start_marker_x =
-          ((float)(audio_state->selection_start - startSample) / visibleSamples) *
+          (float)((double)(audio_state->selection_start - startFrame) / visibleFrames) *
           waveform_width;
     }
   }
 
   float end_marker_x = -1.0f;
-  if (audio_state->selection_end < totalSamples) {
-    if (audio_state->selection_end > startSample &&
-        audio_state->selection_end <= startSample + visibleSamples) {
+  if (audio_state->selection_end < totalFrames) {
+    if (audio_state->selection_end > startFrame &&
+        audio_state->selection_end <= endFrame) {
       end_marker_x =
-          ((float)(audio_state->selection_end - startSample) / visibleSamples) *
+          (float)((double)(audio_state->selection_end - startFrame) / visibleFrames) *
           waveform_width;
     }
   }
@@ -331,12 +331,12 @@ void handle_waveform_interaction(Clay_ElementId elementId,
   }
 
   // --- Interaction logic ---
-  // Calculate clicked_sample with proper clamping to avoid out-of-range indices
-  float click_ratio = click_x / waveform_width;
-  unsigned int clicked_sample = startSample + (unsigned int)(click_ratio * visibleSamples);
-  // Clamp clicked_sample to valid range [0, totalSamples - 1]
-  if (clicked_sample >= totalSamples) {
-    clicked_sample = totalSamples - 1;
+  // Calculate clicked_frame with proper clamping to avoid out-of-range indices
+  double click_ratio = click_x / waveform_width;
+  Sint64 clicked_frame = startFrame + (Sint64)(click_ratio * visibleFrames);
+  // Clamp clicked_frame to valid range [0, totalFrames - 1]
+  if (clicked_frame >= totalFrames) {
+    clicked_frame = totalFrames - 1;
   }
 
   SDL_Keymod mod_state = SDL_GetModState();
@@ -346,18 +346,20 @@ void handle_waveform_interaction(Clay_ElementId elementId,
   if (pointerData.state == CLAY_POINTER_DATA_PRESSED_THIS_FRAME) {
     if (ctrl_pressed && !shift_pressed) {
       app_state->waveform_interaction_state = INTERACTION_DRAGGING_SELECTION;
-      app_state->selection_drag_start = clicked_sample;
-      audio_state->selection_start = clicked_sample;
-      audio_state->selection_end = clicked_sample;
+      app_state->selection_drag_start = clicked_frame;
+      audio_state_set_selection(audio_state, clicked_frame, clicked_frame);
     } else if (ctrl_pressed && shift_pressed) {
-      audio_state->selection_start = clicked_sample;
+      audio_state_set_selection(audio_state, clicked_frame, audio_state->selection_end);
     } else if (app_state->is_hovering_selection_start) {
       app_state->waveform_interaction_state = INTERACTION_DRAGGING_START_MARKER;
     } else if (app_state->is_hovering_selection_end) {
       app_state->waveform_interaction_state = INTERACTION_DRAGGING_END_MARKER;
     } else {
       app_state->waveform_interaction_state = INTERACTION_DRAGGING_PLAYHEAD;
-      audio_state_set_playback_position(audio_state, clicked_sample);
+      // Drags are heard as scrubbing; without a device a click just seeks
+      if (!audio_state_begin_scrub(audio_state, clicked_frame)) {
+        audio_state_set_playback_position(audio_state, clicked_frame);
+      }
     }
   }
 }
@@ -408,8 +410,9 @@ void handle_play_pause(Clay_ElementId elementId, Clay_PointerData pointerData,
     AppState *app_state = (AppState *)userData;
     AudioState *audio_state = app_state->audio_state;
 
-    // Only allow play/pause if we have completed audio processing
-    if (audio_state->status != STATUS_COMPLETED) {
+    // Playback can start on the first decoded chunk, before analysis ends
+    if (audio_state->playback_state == PLAYBACK_STOPPED &&
+        !audio_state_can_play(audio_state)) {
       return;
     }
 
@@ -493,22 +496,8 @@ void handle_file_selection(Clay_ElementId elementId,
       return;
     }
 
-    // If a file was selected, check if we need to stop ongoing processing
-    SDL_LockMutex(audio_state->data_mutex);
-    bool is_processing = (audio_state->status == STATUS_DECODE ||
-                         audio_state->status == STATUS_BEAT_ANALYSIS);
-    SDL_UnlockMutex(audio_state->data_mutex);
-
-    if (is_processing) {
-      // Gracefully stop the ongoing processing
-      audio_state_request_stop(audio_state);
-    } else if (audio_state->processing_thread) {
-      // Wait for any completed thread to finish
-      SDL_WaitThread(audio_state->processing_thread, NULL);
-      audio_state->processing_thread = NULL;
-    }
-
-    // Load the new file
+    // Load the new file. Any load still in progress is cancelled without
+    // waiting for it, so the UI stays responsive.
     audio_state_load_file(audio_state, selectedFile);
   }
 }
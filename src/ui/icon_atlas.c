@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "icon_atlas.h"
+#include <SDL3_image/SDL_image.h>
+#include <stdio.h>
+
+// Transparent gap around each icon so linear filtering never picks up a
+// neighbour
+#define ICON_PADDING 1
+
+static const char *icon_files[ICON_COUNT] = {
+    [ICON_FILE] = "file.svg",
+    [ICON_PLAY] = "play_pause.svg",
+    [ICON_SEND] = "send.svg",
+    [ICON_REMOVE] = "remove.svg",
+    [ICON_HELP] = "help.svg",
+    [ICON_MARK_IN] = "mark_in.svg",
+    [ICON_MARK_OUT] = "mark_out.svg",
+    [ICON_UPDATE] = "update.svg",
+};
+
+// Lay the icons out in one row and upload them as a single texture
+static bool build_texture(IconAtlas *atlas, SDL_Renderer *renderer, float density) {
+  const int size = (int)SDL_ceilf(ICON_SIZE * density);
+  const int cell = size + 2 * ICON_PADDING;
+
+  SDL_Surface *sheet = SDL_CreateSurface(cell * ICON_COUNT, cell, SDL_PIXELFORMAT_ARGB8888);
+  if (!sheet) return false;
+  SDL_FillSurfaceRect(sheet, NULL, 0);
+
+  for (int i = 0; i < ICON_COUNT; i++) {
+    SDL_IOStream *io = SDL_IOFromConstMem(atlas->svg_data[i], atlas->svg_size[i]);
+    SDL_Surface *icon = io ? IMG_LoadSizedSVG_IO(io, size, size) : NULL;
+    if (io) SDL_CloseIO(io);
+    if (!icon) {
+      SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to rasterise %s: %s",
+                   icon_files[i], SDL_GetError());
+      SDL_DestroySurface(sheet);
+      return false;
+    }
+
+    SDL_Rect dst = {i * cell + ICON_PADDING, ICON_PADDING, size, size};
+    SDL_SetSurfaceBlendMode(icon, SDL_BLENDMODE_NONE);
+    SDL_BlitSurfaceScaled(icon, NULL, sheet, &dst, SDL_SCALEMODE_LINEAR);
+    SDL_DestroySurface(icon);
+  }
+
+  SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, sheet);
+  SDL_DestroySurface(sheet);
+  if (!texture) return false;
+
+  if (atlas->texture) SDL_DestroyTexture(atlas->texture);
+  atlas->texture = texture;
+  atlas->density = density;
+  for (int i = 0; i < ICON_COUNT; i++) {
+    atlas->images[i].texture = texture;
+    atlas->images[i].source = (SDL_FRect){(float)(i * cell + ICON_PADDING),
+                                          (float)ICON_PADDING, (float)size, (float)size};
+  }
+  return true;
+}
+
+bool icon_atlas_init(IconAtlas *atlas, SDL_Renderer *renderer, const char *base_path,
+                     float density) {
+  SDL_zerop(atlas);
+
+  char path[1024];
+  for (int i = 0; i < ICON_COUNT; i++) {
+#ifdef __APPLE__
+    snprintf(path, sizeof(path), "%s%s", base_path, icon_files[i]);
+#else
+    snprintf(path, sizeof(path), "%s%s%s", base_path, "resources/", icon_files[i]);
+#endif
+    atlas->svg_data[i] = SDL_LoadFile(path, &atlas->svg_size[i]);
+    if (!atlas->svg_data[i]) {
+      SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load icon %s: %s",
+                   path, SDL_GetError());
+      return false;
+    }
+  }
+
+  return build_texture(atlas, renderer, density > 0.0f ? density : 1.0f);
+}
+
+bool icon_atlas_update(IconAtlas *atlas, SDL_Renderer *renderer, float density) {
+  if (density <= 0.0f || density == atlas->density) return true;
+  return build_texture(atlas, renderer, density);
+}
+
+void icon_atlas_destroy(IconAtlas *atlas) {
+  if (atlas->texture) SDL_DestroyTexture(atlas->texture);
+  for (int i = 0; i < ICON_COUNT; i++) {
+    SDL_free(atlas->svg_data[i]);
+  }
+  SDL_zerop(atlas);
+}
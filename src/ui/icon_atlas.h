@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef UI_ICON_ATLAS_H
+#define UI_ICON_ATLAS_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+#include "../clay_renderer_SDL3.h"
+
+// Size of a header icon in layout units
+#define ICON_SIZE 50
+
+typedef enum {
+  ICON_FILE,
+  ICON_PLAY,
+  ICON_SEND,
+  ICON_REMOVE,
+  ICON_HELP,
+  ICON_MARK_IN,
+  ICON_MARK_OUT,
+  ICON_UPDATE,
+  ICON_COUNT
+} IconId;
+
+// The header icons, rasterised from their SVGs at the window's pixel
+// density into one texture. The SVG sources stay in memory so a density
+// change re-rasterises without touching the disk.
+typedef struct {
+  AtlasImage images[ICON_COUNT];  // Pass &images[id] as Clay imageData
+  void *svg_data[ICON_COUNT];
+  size_t svg_size[ICON_COUNT];
+  SDL_Texture *texture;
+  float density;                  // Density the texture was built for
+} IconAtlas;
+
+// Read the SVGs from resources/ under base_path and build the atlas
+bool icon_atlas_init(IconAtlas *atlas, SDL_Renderer *renderer, const char *base_path,
+                     float density);
+
+// Rebuild the atlas if `density` differs from the one it was built for
+bool icon_atlas_update(IconAtlas *atlas, SDL_Renderer *renderer, float density);
+
+void icon_atlas_destroy(IconAtlas *atlas);
+
+#endif // UI_ICON_ATLAS_H
@@ -22,6 +22,11 @@
 #include <stdio.h>
 #include <string.h>
 
+// Indeterminate progress: a segment covering this share of the unfilled
+// bar goes back and forth once every PROGRESS_SWEEP_MS
+#define PROGRESS_SWEEP_WIDTH 0.2f
+#define PROGRESS_SWEEP_MS 1600
+
 static void build_modal(AppState *state) {
   // Overlay
   CLAY_AUTO_ID({
@@ -74,30 +79,30 @@ static void build_header_bar(AppState *state) {
                    .childAlignment = {.y = CLAY_ALIGN_Y_CENTER}},
         .backgroundColor = COLOR_BG_LIGHT,
         .cornerRadius = CLAY_CORNER_RADIUS(8)}) {
-    headerButton(CLAY_ID("FileButton"), CLAY_ID("FileIcon"), state->file_icon,
+    headerButton(CLAY_ID("FileButton"), CLAY_ID("FileIcon"), &state->icons.images[ICON_FILE],
                  "Open audio file (Ctrl+F)", handle_file_selection,
                  (intptr_t)state);
 
-    headerButton(CLAY_ID("PlayButton"), CLAY_ID("PlayIcon"), state->play_icon,
+    headerButton(CLAY_ID("PlayButton"), CLAY_ID("PlayIcon"), &state->icons.images[ICON_PLAY],
                  "Play/Pause (Space)", handle_play_pause, (intptr_t)state);
 
-    headerButton(CLAY_ID("SendButton"), CLAY_ID("SendIcon"), state->send_icon,
+    headerButton(CLAY_ID("SendButton"), CLAY_ID("SendIcon"), &state->icons.images[ICON_SEND],
                  "Send markers to connected app (Ctrl+Enter)", handle_send_markers,
                  (intptr_t)state);
 
     headerButton(CLAY_ID("RemoveButton"), CLAY_ID("RemoveIcon"),
-                 state->remove_icon, "Remove all markers from connected app (Ctrl+Backspace)",
+                 &state->icons.images[ICON_REMOVE], "Remove all markers from connected app (Ctrl+Backspace)",
                  handle_remove_markers, (intptr_t)state);
 
     headerButton(CLAY_ID("MarkInButton"), CLAY_ID("MarkInIcon"),
-                 state->mark_in_icon, "Set selection start", handle_mark_in,
+                 &state->icons.images[ICON_MARK_IN], "Set selection start", handle_mark_in,
                  (intptr_t)state);
 
     headerButton(CLAY_ID("MarkOutButton"), CLAY_ID("MarkOutIcon"),
-                 state->mark_out_icon, "Set selection end", handle_mark_out,
+                 &state->icons.images[ICON_MARK_OUT], "Set selection end", handle_mark_out,
                  (intptr_t)state);
 
-    headerButton(CLAY_ID("HelpButton"), CLAY_ID("HelpIcon"), state->help_icon,
+    headerButton(CLAY_ID("HelpButton"), CLAY_ID("HelpIcon"), &state->icons.images[ICON_HELP],
                  "Help", handle_help, (intptr_t)state);
 
     if (state->updater_state->status == UPDATE_STATUS_AVAILABLE || state->updater_state->status == UPDATE_STATUS_DOWNLOADING) {
@@ -107,7 +112,7 @@ static void build_header_bar(AppState *state) {
       } else {
           snprintf(tooltip, sizeof(tooltip), "Update to %s", state->updater_state->latest_version);
       }
-      headerButton(CLAY_ID("UpdateButton"), CLAY_ID("UpdateIcon"), state->update_icon,
+      headerButton(CLAY_ID("UpdateButton"), CLAY_ID("UpdateIcon"), &state->icons.images[ICON_UPDATE],
                    tooltip, handle_update_button, (intptr_t)state);
     }
 
@@ -193,7 +198,12 @@ static void build_main_content(AppState *state) {
         .cornerRadius = CLAY_CORNER_RADIUS(8)}) {
     // Create waveform data with current zoom and scroll values
     state->waveformData = (WaveformData){.samples = NULL,
-                                 .sampleCount = 0,
+                                 .channels = 0,
+                                 .frameCount = 0,
+                                 .decodedFrames = 0,
+                                 .peaks = NULL,
+                                 .peakFrames = 0,
+                                 .sourceId = 0,
                                  .beat_positions = NULL,
                                  .beat_count = 0,
                                  .currentZoom = state->waveform_view.zoom,
@@ -208,14 +218,27 @@ static void build_main_content(AppState *state) {
                                  .is_hovering_selection_start = state->is_hovering_selection_start,
                                  .is_hovering_selection_end = state->is_hovering_selection_end};
 
-    // If we have audio data, use it
+    // Hold a reference to the decoded audio until the next frame so the
+    // renderer can read it without locking, even if the decoder moves on
+    // to a bigger buffer in the meantime
+    pcm_buffer_release(state->waveform_pcm);
+    state->waveform_pcm = audio_state_acquire_pcm(state->audio_state);
+
+    // If we have audio data, use it. While decoding, only the published
+    // prefix of the buffer is drawn and the rest of the track stays empty,
+    // unless the peaks of a cached file already cover it.
     SDL_LockMutex(state->audio_state->data_mutex);
-    if (state->audio_state->status >= STATUS_BEAT_ANALYSIS &&
-        state->audio_state->sample->buffer &&
-        state->audio_state->sample->buffer_size > 0) {
-      state->waveformData.samples = state->audio_state->sample->buffer;
-      state->waveformData.sampleCount =
-          state->audio_state->sample->buffer_size / sizeof(float);
+    Sint64 decoded_frames = pcm_buffer_frames(state->waveform_pcm);
+    Sint64 peak_frames = state->waveform_pcm ? state->waveform_pcm->peaks.seeded_frames : 0;
+    if (state->audio_state->status >= STATUS_DECODE &&
+        (decoded_frames > 0 || peak_frames > 0)) {
+      state->waveformData.samples = state->waveform_pcm->samples;
+      state->waveformData.channels = state->audio_state->channels;
+      state->waveformData.frameCount = state->audio_state->total_frames;
+      state->waveformData.decodedFrames = decoded_frames;
+      state->waveformData.peaks = &state->waveform_pcm->peaks;
+      state->waveformData.peakFrames = peak_frames;
+      state->waveformData.sourceId = state->audio_state->load_generation;
 
       // Add beat positions if available
       if (state->audio_state->beat_positions &&
@@ -232,39 +255,31 @@ static void build_main_content(AppState *state) {
         }
       }
 
-      // Add playback cursor if the track is loaded
-      if (state->audio_state->status == STATUS_COMPLETED) {
+      // Add playback cursor if the track is loaded, or already playing
+      // while it loads
+      if (state->audio_state->status == STATUS_COMPLETED ||
+          state->audio_state->playback_state != PLAYBACK_STOPPED) {
         state->waveformData.showPlaybackCursor = true;
         state->waveformData.selection_start = state->audio_state->selection_start;
         state->waveformData.selection_end = state->audio_state->selection_end;
 
-        unsigned int raw_pos =
-            audio_state_get_playback_position(state->audio_state);
-
-        // Compensate for audio buffer latency
-        int latency_bytes = 0;
-        if (state->audio_state->audio_stream) {
-          latency_bytes =
-              SDL_GetAudioStreamQueued(state->audio_state->audio_stream);
-        }
-        int latency_samples = latency_bytes / sizeof(float);
-
-        int corrected_pos = raw_pos - latency_samples;
-        if (corrected_pos < 0) {
-          corrected_pos = 0;
-        }
-
-        state->waveformData.playbackPosition = (unsigned int)corrected_pos;
+        // What is being heard right now, not what was last queued
+        state->waveformData.playbackPosition =
+            audio_state_get_audible_position(state->audio_state, SDL_GetTicksNS());
       }
 
       // Debug info
       static bool logged_waveform = false;
-      if (!logged_waveform) {
-        printf("Waveform display using %d samples\n",
-               state->waveformData.sampleCount);
+      if (!logged_waveform && state->audio_state->status == STATUS_COMPLETED) {
+        printf("Waveform display using %" SDL_PRIs64 " frames\n",
+               state->waveformData.frameCount);
         logged_waveform = true;
       }
     }
+    bool is_processing = state->audio_state->status == STATUS_DECODE ||
+                         state->audio_state->status == STATUS_BEAT_ANALYSIS;
+    float progress = state->audio_state->processing_progress;
+    bool progress_indeterminate = state->audio_state->progress_indeterminate;
     SDL_UnlockMutex(state->audio_state->data_mutex);
 
     CLAY_AUTO_ID({.layout = {.sizing = {.width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(1)}, .layoutDirection = CLAY_TOP_TO_BOTTOM, .childGap = 8}}) {
@@ -279,6 +294,24 @@ static void build_main_content(AppState *state) {
         Clay_OnHover(handle_waveform_interaction, (intptr_t)state);
       }
 
+      // Decode/analysis progress
+      if (is_processing) {
+          CLAY(CLAY_ID("ProgressBar"), {.layout = {.sizing = {.width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(6)}}, .backgroundColor = COLOR_WAVEFORM_BG, .cornerRadius = CLAY_CORNER_RADIUS(3)}) {
+              CLAY(CLAY_ID("ProgressBarFill"), {.layout = {.sizing = {.width = CLAY_SIZING_PERCENT(progress), .height = CLAY_SIZING_GROW(0)}}, .backgroundColor = COLOR_ACCENT, .cornerRadius = CLAY_CORNER_RADIUS(3)});
+
+              // Beat tracking reports nothing until it is done: sweep a
+              // segment across the rest of the bar so it doesn't look stuck
+              if (progress_indeterminate) {
+                  float remaining = 1.0f - progress;
+                  float segment = remaining * PROGRESS_SWEEP_WIDTH;
+                  float phase = (float)(SDL_GetTicks() % PROGRESS_SWEEP_MS) / PROGRESS_SWEEP_MS;
+                  float sweep = phase < 0.5f ? phase * 2.0f : 2.0f - phase * 2.0f;
+                  CLAY_AUTO_ID({.layout = {.sizing = {.width = CLAY_SIZING_PERCENT((remaining - segment) * sweep), .height = CLAY_SIZING_GROW(0)}}});
+                  CLAY(CLAY_ID("ProgressBarSweep"), {.layout = {.sizing = {.width = CLAY_SIZING_PERCENT(segment), .height = CLAY_SIZING_GROW(0)}}, .backgroundColor = COLOR_ACCENT, .cornerRadius = CLAY_CORNER_RADIUS(3)});
+              }
+          }
+      }
+
       // Scrollbar
       if (state->audio_state->status == STATUS_COMPLETED && state->waveform_view.zoom > 1.0f) {
           CLAY(CLAY_ID("Scrollbar"), {.layout = {.sizing = {.width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(12)}, .childAlignment = {.y = CLAY_ALIGN_Y_CENTER}}, .backgroundColor = COLOR_WAVEFORM_BG, .cornerRadius = CLAY_CORNER_RADIUS(6)}) {
@@ -0,0 +1,160 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "perf_hud.h"
+
+#define HUD_MARGIN 8
+#define HUD_LINE_HEIGHT 10  // SDL's debug font is 8x8
+
+static const char *metric_names[PERF_METRIC_COUNT] = {
+    [PERF_FRAME] = "frame",
+    [PERF_NETWORK] = "network",
+    [PERF_LAYOUT] = "layout",
+    [PERF_RENDER] = "render",
+    [PERF_WAVEFORM] = " waveform",
+    [PERF_PRESENT] = "present",
+    [PERF_AUDIO_CALLBACK] = "audio cb",
+    [PERF_INPUT_LATENCY] = "input lat",
+};
+
+static float ticks_to_ms(Uint64 ticks) {
+  return (float)((double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+static int compare_floats(const void *a, const void *b) {
+  const float x = *(const float *)a;
+  const float y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+void perf_hud_toggle(PerfHud *hud, Clay_SDL3RendererData *renderer_data, AudioState *audio) {
+  hud->visible = !hud->visible;
+  if (hud->visible) {
+    // Start from a clean window so stale numbers don't skew the percentiles
+    SDL_zeroa(hud->series);
+    hud->pending_input_ns = 0;
+  }
+  renderer_data->timeCommands = hud->visible;
+  if (audio) {
+    SDL_SetAtomicInt(&audio->callback_peak_ns, 0);
+    SDL_SetAtomicInt(&audio->callback_timing, hud->visible ? 1 : 0);
+  }
+}
+
+void perf_hud_add(PerfHud *hud, PerfMetric metric, float ms) {
+  PerfSeries *series = &hud->series[metric];
+  series->ms[series->next] = ms;
+  series->next = (series->next + 1) % PERF_HUD_HISTORY;
+  if (series->count < PERF_HUD_HISTORY) series->count++;
+}
+
+void perf_hud_end(PerfHud *hud, PerfMetric metric, Uint64 started) {
+  if (started == 0) return;
+  perf_hud_add(hud, metric, ticks_to_ms(SDL_GetPerformanceCounter() - started));
+}
+
+void perf_hud_note_input(PerfHud *hud, Uint64 timestamp_ns) {
+  if (hud->visible && hud->pending_input_ns == 0) {
+    hud->pending_input_ns = timestamp_ns;
+  }
+}
+
+void perf_hud_collect(PerfHud *hud, const Clay_SDL3RendererData *renderer_data,
+                      AudioState *audio) {
+  if (!hud->visible) return;
+
+  hud->render = renderer_data->stats;
+  perf_hud_add(hud, PERF_WAVEFORM, ticks_to_ms(hud->render.waveformTicks));
+
+  // Take the longest callback since the last frame and restart the peak
+  if (audio) {
+    const int peak_ns = SDL_SetAtomicInt(&audio->callback_peak_ns, 0);
+    if (peak_ns > 0) {
+      perf_hud_add(hud, PERF_AUDIO_CALLBACK, peak_ns / 1e6f);
+    }
+    hud->xruns = SDL_GetAtomicInt(&audio->xrun_count);
+  }
+}
+
+void perf_hud_presented(PerfHud *hud) {
+  if (!hud->visible || hud->pending_input_ns == 0) return;
+
+  const Uint64 now = SDL_GetTicksNS();
+  if (now > hud->pending_input_ns) {
+    perf_hud_add(hud, PERF_INPUT_LATENCY, (float)((now - hud->pending_input_ns) / 1e6));
+  }
+  hud->pending_input_ns = 0;
+}
+
+// p-th percentile (0..1) of `count` sorted samples
+static float percentile(const float *sorted, int count, float p) {
+  return sorted[(int)(p * (count - 1) + 0.5f)];
+}
+
+void perf_hud_draw(PerfHud *hud, SDL_Renderer *renderer) {
+  if (!hud->visible) return;
+
+  const int lines = PERF_METRIC_COUNT + 6;
+  const SDL_FRect background = {0, 0, 2 * HUD_MARGIN + 50 * 8,
+                                2 * HUD_MARGIN + lines * HUD_LINE_HEIGHT};
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 200);
+  SDL_RenderFillRect(renderer, &background);
+
+  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+  float y = HUD_MARGIN;
+  SDL_RenderDebugText(renderer, HUD_MARGIN, y, "ms          last    p50    p95    p99    max");
+  y += HUD_LINE_HEIGHT;
+
+  float sorted[PERF_HUD_HISTORY];
+  for (int m = 0; m < PERF_METRIC_COUNT; m++, y += HUD_LINE_HEIGHT) {
+    const PerfSeries *series = &hud->series[m];
+    if (series->count == 0) {
+      SDL_RenderDebugTextFormat(renderer, HUD_MARGIN, y, "%-10s      -", metric_names[m]);
+      continue;
+    }
+    const float last = series->ms[(series->next + PERF_HUD_HISTORY - 1) % PERF_HUD_HISTORY];
+    SDL_memcpy(sorted, series->ms, series->count * sizeof(float));
+    SDL_qsort(sorted, series->count, sizeof(float), compare_floats);
+    SDL_RenderDebugTextFormat(renderer, HUD_MARGIN, y, "%-10s %6.2f %6.2f %6.2f %6.2f %6.2f",
+                              metric_names[m], last,
+                              percentile(sorted, series->count, 0.50f),
+                              percentile(sorted, series->count, 0.95f),
+                              percentile(sorted, series->count, 0.99f),
+                              sorted[series->count - 1]);
+  }
+
+  const RenderStats *render = &hud->render;
+  y += HUD_LINE_HEIGHT;
+  SDL_RenderDebugTextFormat(renderer, HUD_MARGIN, y, "%d commands, %d draw calls, %d batches",
+                            render->commands, render->drawCalls, render->batches);
+  y += HUD_LINE_HEIGHT;
+  SDL_RenderDebugTextFormat(renderer, HUD_MARGIN, y, "%d clip changes, %d audio xruns",
+                            render->clipChanges, hud->xruns);
+  y += HUD_LINE_HEIGHT;
+  SDL_RenderDebugTextFormat(renderer, HUD_MARGIN, y, "rect %.2f  border %.2f  text %.2f",
+                            ticks_to_ms(render->commandTicks[CLAY_RENDER_COMMAND_TYPE_RECTANGLE]),
+                            ticks_to_ms(render->commandTicks[CLAY_RENDER_COMMAND_TYPE_BORDER]),
+                            ticks_to_ms(render->commandTicks[CLAY_RENDER_COMMAND_TYPE_TEXT]));
+  y += HUD_LINE_HEIGHT;
+  SDL_RenderDebugTextFormat(renderer, HUD_MARGIN, y, "image %.2f  clip %.2f  custom %.2f",
+                            ticks_to_ms(render->commandTicks[CLAY_RENDER_COMMAND_TYPE_IMAGE]),
+                            ticks_to_ms(render->commandTicks[CLAY_RENDER_COMMAND_TYPE_SCISSOR_START] +
+                                        render->commandTicks[CLAY_RENDER_COMMAND_TYPE_SCISSOR_END]),
+                            ticks_to_ms(render->commandTicks[CLAY_RENDER_COMMAND_TYPE_CUSTOM]));
+}
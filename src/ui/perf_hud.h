@@ -0,0 +1,86 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef UI_PERF_HUD_H
+#define UI_PERF_HUD_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+#include "../audio_state.h"
+#include "../clay_renderer_SDL3.h"
+
+// Frames of history the percentiles are taken over
+#define PERF_HUD_HISTORY 240
+
+typedef enum {
+  PERF_FRAME,           // Layout, render and present of one frame
+  PERF_NETWORK,         // curl_manager_update
+  PERF_LAYOUT,          // build_ui and Clay_EndLayout
+  PERF_RENDER,          // SDL_Clay_RenderClayCommands
+  PERF_WAVEFORM,        // DrawWaveform, part of PERF_RENDER
+  PERF_PRESENT,         // SDL_RenderPresent
+  PERF_AUDIO_CALLBACK,  // Longest audio callback since the previous frame
+  PERF_INPUT_LATENCY,   // Playhead drag motion event to the present showing it
+  PERF_METRIC_COUNT
+} PerfMetric;
+
+// Rolling window of samples, in milliseconds
+typedef struct {
+  float ms[PERF_HUD_HISTORY];
+  int next;
+  int count;
+} PerfSeries;
+
+// Toggleable overlay with frame and subsystem timings. While it's hidden
+// perf_hud_begin returns 0 and nothing is measured.
+typedef struct {
+  bool visible;
+  PerfSeries series[PERF_METRIC_COUNT];
+  RenderStats render;        // Copy of the last frame's renderer counters
+  Uint64 pending_input_ns;   // Oldest playhead drag event not yet presented, 0 if none
+  int xruns;                 // Audio callback xruns so far
+} PerfHud;
+
+// Show or hide the overlay, switching the renderer and audio timing with it
+void perf_hud_toggle(PerfHud *hud, Clay_SDL3RendererData *renderer_data, AudioState *audio);
+
+// Start timing a section. Returns 0 while the overlay is hidden.
+static inline Uint64 perf_hud_begin(const PerfHud *hud) {
+  return hud->visible ? SDL_GetPerformanceCounter() : 0;
+}
+
+// Record the time since perf_hud_begin returned `started`; no-op for 0
+void perf_hud_end(PerfHud *hud, PerfMetric metric, Uint64 started);
+
+void perf_hud_add(PerfHud *hud, PerfMetric metric, float ms);
+
+// Note a playhead drag event, timestamped in SDL_GetTicksNS() time
+void perf_hud_note_input(PerfHud *hud, Uint64 timestamp_ns);
+
+// Collect the per-frame figures from the renderer and the audio callback.
+// Call after SDL_Clay_RenderClayCommands.
+void perf_hud_collect(PerfHud *hud, const Clay_SDL3RendererData *renderer_data,
+                      AudioState *audio);
+
+// Record input latency for the frame just presented
+void perf_hud_presented(PerfHud *hud);
+
+// Draw the overlay in the top-left corner with SDL's debug font
+void perf_hud_draw(PerfHud *hud, SDL_Renderer *renderer);
+
+#endif // UI_PERF_HUD_H
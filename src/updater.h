@@ -1,10 +1,8 @@
 #ifndef UPDATER_H
 #define UPDATER_H
 
-#define UPDATER_ORG "acrilique"
-#define UPDATER_APP "automarker-c"
-
 #include <stdbool.h>
+#include "app_paths.h"
 #include "connections/curl_manager.h"
 
 typedef enum {
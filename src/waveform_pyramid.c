@@ -0,0 +1,241 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "waveform_pyramid.h"
+#include "dsp/convert.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    float min;
+    float max;
+    double sum_squares;
+    Sint64 frames;
+} PeakAccumulator;
+
+static Sint64 level_span(int level) {
+    return (Sint64)WAVEFORM_PEAK_BLOCK << level;
+}
+
+Sint64 waveform_pyramid_layout(Sint64 frames, Sint64 counts[WAVEFORM_PYRAMID_MAX_LEVELS],
+                               int *level_count) {
+    Sint64 total = 0;
+    int levels = 0;
+    while (frames > 0 && levels < WAVEFORM_PYRAMID_MAX_LEVELS) {
+        Sint64 span = level_span(levels);
+        counts[levels] = (frames + span - 1) / span;
+        total += counts[levels];
+        levels++;
+        if (span >= frames) break;
+    }
+    *level_count = levels;
+    return total;
+}
+
+// Point each level at its part of `block`
+static void assign_levels(WaveformPyramid *pyramid, WaveformPeak *block) {
+    for (int level = 0; level < pyramid->level_count; level++) {
+        pyramid->levels[level] = block;
+        block += pyramid->counts[level];
+    }
+}
+
+bool waveform_pyramid_init(WaveformPyramid *pyramid, Sint64 capacity_frames) {
+    SDL_zerop(pyramid);
+    if (capacity_frames <= 0) return false;
+
+    const Sint64 total = waveform_pyramid_layout(capacity_frames, pyramid->counts,
+                                                 &pyramid->level_count);
+
+    // One block for every level, largest first
+    WaveformPeak *block = SDL_malloc((size_t)total * sizeof(WaveformPeak));
+    if (!block) {
+        SDL_zerop(pyramid);
+        return false;
+    }
+    assign_levels(pyramid, block);
+    return true;
+}
+
+void waveform_pyramid_wrap(WaveformPyramid *pyramid, const WaveformPeak *entries,
+                           Sint64 frames) {
+    SDL_zerop(pyramid);
+    if (frames <= 0) return;
+
+    waveform_pyramid_layout(frames, pyramid->counts, &pyramid->level_count);
+    // Never written through: with every frame summarised, updates do nothing
+    assign_levels(pyramid, (WaveformPeak *)entries);
+    pyramid->frames = frames;
+    pyramid->seeded_frames = frames;
+}
+
+void waveform_pyramid_free(WaveformPyramid *pyramid) {
+    if (!pyramid) return;
+    SDL_free(pyramid->levels[0]);
+    SDL_zerop(pyramid);
+}
+
+static WaveformPeak summarise_block(const float *samples, int channels) {
+    float mono[WAVEFORM_PEAK_BLOCK];
+    convert_downmix_f32(samples, mono, WAVEFORM_PEAK_BLOCK, channels);
+
+    WaveformPeak peak;
+    float sum_squares;
+    convert_peak_f32(mono, WAVEFORM_PEAK_BLOCK, &peak.min, &peak.max, &sum_squares);
+    peak.rms = sqrtf(sum_squares / WAVEFORM_PEAK_BLOCK);
+    return peak;
+}
+
+// Both children cover the same number of frames, so their mean squares
+// carry equal weight.
+//
+// This is a box filter, and deliberately so. Each entry is the exact
+// statistic of its own frames, not a resampled signal. The mean square of
+// the parent is exactly the mean of its children's, so no energy is lost or
+// folded between levels, and min/max stay exact extremes. What a box
+// can't do is smooth the RMS envelope across neighbouring entries. At
+// coarse levels it can therefore step between columns where a wider
+// windowed filter would blend them. Each pixel column shows exactly its
+// own frames, which is what the drawing wants, so we accept that.
+static WaveformPeak merge_children(const WaveformPeak *a, const WaveformPeak *b) {
+    WaveformPeak peak;
+    peak.min = a->min < b->min ? a->min : b->min;
+    peak.max = a->max > b->max ? a->max : b->max;
+    peak.rms = sqrtf((a->rms * a->rms + b->rms * b->rms) * 0.5f);
+    return peak;
+}
+
+void waveform_pyramid_update(WaveformPyramid *pyramid, const float *samples,
+                             int channels, Sint64 frames) {
+    if (!pyramid->levels[0] || frames <= pyramid->frames) return;
+
+    const Sint64 previous = pyramid->frames;
+    for (Sint64 i = previous / WAVEFORM_PEAK_BLOCK; i < frames / WAVEFORM_PEAK_BLOCK; i++) {
+        pyramid->levels[0][i] = summarise_block(samples + i * WAVEFORM_PEAK_BLOCK * channels,
+                                                channels);
+    }
+
+    for (int level = 1; level < pyramid->level_count; level++) {
+        const Sint64 span = level_span(level);
+        const WaveformPeak *children = pyramid->levels[level - 1];
+        for (Sint64 i = previous / span; i < frames / span; i++) {
+            pyramid->levels[level][i] = merge_children(&children[2 * i], &children[2 * i + 1]);
+        }
+    }
+
+    pyramid->frames = frames;
+}
+
+void waveform_pyramid_copy(WaveformPyramid *dst, const WaveformPyramid *src,
+                           Sint64 frames) {
+    int levels = src->level_count < dst->level_count ? src->level_count : dst->level_count;
+    for (int level = 0; level < levels; level++) {
+        Sint64 count = frames / level_span(level);
+        if (count > 0) {
+            memcpy(dst->levels[level], src->levels[level], (size_t)count * sizeof(WaveformPeak));
+        }
+    }
+    dst->frames = frames;
+}
+
+void waveform_pyramid_seed(WaveformPyramid *dst, const WaveformPyramid *src) {
+    waveform_pyramid_copy(dst, src, src->frames);
+    dst->seeded_frames = src->frames;
+}
+
+int waveform_pyramid_level_for(const WaveformPyramid *pyramid, double frames_per_pixel) {
+    if (!pyramid || pyramid->level_count == 0 || frames_per_pixel < WAVEFORM_PEAK_BLOCK) {
+        return -1;
+    }
+
+    int level = (int)floor(log2(frames_per_pixel / WAVEFORM_PEAK_BLOCK));
+    if (level >= pyramid->level_count) level = pyramid->level_count - 1;
+    return level;
+}
+
+static void accumulate_peak(PeakAccumulator *acc, float min, float max,
+                            double sum_squares, Sint64 frames) {
+    if (acc->frames == 0 || min < acc->min) acc->min = min;
+    if (acc->frames == 0 || max > acc->max) acc->max = max;
+    acc->sum_squares += sum_squares;
+    acc->frames += frames;
+}
+
+static void accumulate_samples(PeakAccumulator *acc, const float *samples,
+                               int channels, Sint64 from, Sint64 to) {
+    float mono[WAVEFORM_PEAK_BLOCK];
+    for (Sint64 frame = from; frame < to; frame += WAVEFORM_PEAK_BLOCK) {
+        Sint64 count = to - frame;
+        if (count > WAVEFORM_PEAK_BLOCK) count = WAVEFORM_PEAK_BLOCK;
+        convert_downmix_f32(samples + frame * channels, mono, (size_t)count, channels);
+
+        float min, max, sum_squares;
+        convert_peak_f32(mono, (size_t)count, &min, &max, &sum_squares);
+        accumulate_peak(acc, min, max, sum_squares, count);
+    }
+}
+
+// Use complete entries of `level` for as much of [from, to) as they cover,
+// then finish the range one level down. Only the decoding frontier ever
+// needs more than one level.
+static void accumulate_level(PeakAccumulator *acc, const WaveformPyramid *pyramid,
+                             const float *samples, int channels, Sint64 available,
+                             int level, Sint64 from, Sint64 to) {
+    if (level < 0) {
+        // Seeded entries may reach further, but the samples stop here
+        if (to > available) to = available;
+        if (from < to) {
+            accumulate_samples(acc, samples, channels, from, to);
+        }
+        return;
+    }
+
+    const Sint64 span = level_span(level);
+    const Sint64 complete = SDL_max(available, pyramid->seeded_frames) / span;
+    Sint64 i = from / span;
+    for (; i < complete && i * span < to; i++) {
+        const WaveformPeak *peak = &pyramid->levels[level][i];
+        accumulate_peak(acc, peak->min, peak->max,
+                        (double)peak->rms * peak->rms * span, span);
+    }
+
+    Sint64 covered = i * span;
+    if (covered < to) {
+        accumulate_level(acc, pyramid, samples, channels, available, level - 1,
+                         covered > from ? covered : from, to);
+    }
+}
+
+bool waveform_pyramid_query(const WaveformPyramid *pyramid, const float *samples,
+                            int channels, Sint64 available, int level,
+                            Sint64 from, Sint64 to, WaveformPeak *out) {
+    if (from < 0) from = 0;
+    if (to > SDL_max(available, pyramid->seeded_frames)) {
+        to = SDL_max(available, pyramid->seeded_frames);
+    }
+    if (level >= pyramid->level_count) level = pyramid->level_count - 1;
+
+    PeakAccumulator acc = {0};
+    accumulate_level(&acc, pyramid, samples, channels, available, level, from, to);
+    if (acc.frames == 0) return false;
+
+    out->min = acc.min;
+    out->max = acc.max;
+    out->rms = (float)sqrt(acc.sum_squares / (double)acc.frames);
+    return true;
+}
@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef WAVEFORM_PYRAMID_H
+#define WAVEFORM_PYRAMID_H
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+
+// Frames summarised by one peak
+#define WAVEFORM_PEAK_BLOCK 256
+
+// Enough levels for 2^40 frames
+#define WAVEFORM_PYRAMID_MAX_LEVELS 32
+
+// Mono summary of a run of frames
+typedef struct {
+    float min;
+    float max;
+    float rms;
+} WaveformPeak;
+
+// Min/max/RMS mipmap of a growing PCM buffer.
+//
+// Entry i of level L summarises frames [i * span, (i + 1) * span), with
+// span = WAVEFORM_PEAK_BLOCK << L. Entries are only written once all of
+// their frames are known, and before those frames are published, so a
+// reader that has seen `available` published frames can use every entry
+// that ends at or before `available` without locking. Everything past the
+// last complete entry is read from the samples themselves.
+//
+// A pyramid can also be seeded from a cached one before it is shared. Its
+// entries then cover `seeded_frames` frames ahead of the samples, so the
+// waveform can be drawn before they arrive.
+typedef struct {
+    WaveformPeak *levels[WAVEFORM_PYRAMID_MAX_LEVELS];
+    Sint64 counts[WAVEFORM_PYRAMID_MAX_LEVELS];   // Entries allocated per level
+    int level_count;
+    Sint64 frames;          // Frames summarised so far. Writer only.
+    Sint64 seeded_frames;   // Frames covered from the start. Immutable once shared.
+} WaveformPyramid;
+
+// Entries per level of a pyramid for `frames` frames, which
+// waveform_pyramid_init allocates as one block, largest level first.
+// Returns the total number of entries.
+Sint64 waveform_pyramid_layout(Sint64 frames, Sint64 counts[WAVEFORM_PYRAMID_MAX_LEVELS],
+                               int *level_count);
+
+// Allocate levels for up to capacity_frames frames
+bool waveform_pyramid_init(WaveformPyramid *pyramid, Sint64 capacity_frames);
+void waveform_pyramid_free(WaveformPyramid *pyramid);
+
+// Read-only view of a finished pyramid for `frames` frames, stored as one
+// block in waveform_pyramid_layout order (e.g. in a mapped file). Not to be
+// freed or updated.
+void waveform_pyramid_wrap(WaveformPyramid *pyramid, const WaveformPeak *entries,
+                           Sint64 frames);
+
+// Summarise frames [pyramid->frames, frames) of `samples`, which holds
+// interleaved audio with `channels` channels
+void waveform_pyramid_update(WaveformPyramid *pyramid, const float *samples,
+                             int channels, Sint64 frames);
+
+// Copy the entries covering the first `frames` frames into a pyramid
+// with at least as much capacity
+void waveform_pyramid_copy(WaveformPyramid *dst, const WaveformPyramid *src,
+                           Sint64 frames);
+
+// Fill a new pyramid with every entry of the finished pyramid `src`, so
+// updates for the frames it covers do nothing and queries use its entries
+// before the samples are there. Call before `dst` is shared.
+void waveform_pyramid_seed(WaveformPyramid *dst, const WaveformPyramid *src);
+
+// Coarsest level whose entries span at most frames_per_pixel frames, or -1
+// when a pixel covers less than one entry and samples should be read directly
+int waveform_pyramid_level_for(const WaveformPyramid *pyramid, double frames_per_pixel);
+
+// Summary of frames [from, to) clamped to `available` (or to the seeded
+// frames, where the samples aren't needed), read from `level`
+// (see waveform_pyramid_level_for). The range is widened to whole entries
+// of that level so no peak between two pixels is dropped. Returns false
+// when the range is empty.
+bool waveform_pyramid_query(const WaveformPyramid *pyramid, const float *samples,
+                            int channels, Sint64 available, int level,
+                            Sint64 from, Sint64 to, WaveformPeak *out);
+
+#endif // WAVEFORM_PYRAMID_H
@@ -0,0 +1,262 @@
+/**
+ * Copyright (C) 2025 Lluc Simó Margalef
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Checks every SIMD conversion kernel the CPU supports against the scalar
+// reference: odd lengths, unaligned starts and tails, full-scale integers,
+// out-of-range floats, infinities and NaN, plus the dispatched decimator
+// against its definition. Run by ctest.
+
+#include "../src/dsp/convert_impl.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_COUNT 1100
+
+typedef struct {
+    const char *name;
+    bool (*supported)(void);
+    void (*s16_to_f32)(const Sint16 *in, float *out, size_t count);
+    void (*s32_to_f32)(const Sint32 *in, float *out, size_t count);
+    void (*downmix)(const float *in, float *out, size_t frames, int channels);
+    void (*peak)(const float *in, size_t count, float *out_min, float *out_max,
+                 float *out_sum_squares);
+} Variant;
+
+static const Variant variants[] = {
+#ifdef AUTOMARKER_HAVE_SSE2
+    {"sse2", SDL_HasSSE2, convert_s16_to_f32_sse2, convert_s32_to_f32_sse2,
+     convert_downmix_f32_sse2, convert_peak_f32_sse2},
+#endif
+#ifdef AUTOMARKER_HAVE_AVX2
+    {"avx2", SDL_HasAVX2, convert_s16_to_f32_avx2, convert_s32_to_f32_avx2,
+     convert_downmix_f32_avx2, convert_peak_f32_avx2},
+#endif
+#ifdef AUTOMARKER_HAVE_NEON
+    {"neon", SDL_HasNEON, convert_s16_to_f32_neon, convert_s32_to_f32_neon,
+     convert_downmix_f32_neon, convert_peak_f32_neon},
+#endif
+    {NULL, NULL, NULL, NULL, NULL, NULL}
+};
+
+// Lengths around every vector width, and longer runs with odd tails
+static const size_t counts[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 65, 255, 1023, 1031};
+#define COUNT_COUNT (sizeof(counts) / sizeof(counts[0]))
+
+// Start offsets in elements, so loads begin off any vector alignment
+#define MAX_OFFSET 3
+
+static int failures = 0;
+static Uint32 random_state = 12345;
+
+static Uint32 next_random(void) {
+    random_state = random_state * 1664525u + 1013904223u;
+    return random_state;
+}
+
+// Mostly in [-1.5, 1.5], which clips, with specials sprinkled in
+static float random_sample(void) {
+    const Uint32 r = next_random();
+    switch (r % 64) {
+        case 0: return NAN;
+        case 1: return INFINITY;
+        case 2: return -INFINITY;
+        case 3: return 0.0f;
+        case 4: return -0.0f;
+        case 5: return 1e30f;
+        default: return ((float)(r >> 8) / (float)(1 << 24)) * 3.0f - 1.5f;
+    }
+}
+
+static bool same_float(float a, float b) {
+    return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static void fail(const char *variant, const char *kernel, size_t count, size_t offset,
+                 size_t index, float expected, float got) {
+    printf("FAIL %s %s count=%zu offset=%zu [%zu]: expected %.9g, got %.9g\n",
+           variant, kernel, count, offset, index, expected, got);
+    failures++;
+}
+
+static void compare(const char *variant, const char *kernel, size_t count, size_t offset,
+                    const float *expected, const float *got) {
+    for (size_t i = 0; i < count; i++) {
+        if (!same_float(expected[i], got[i])) {
+            fail(variant, kernel, count, offset, i, expected[i], got[i]);
+            return;
+        }
+    }
+}
+
+static void test_s16(const Variant *v) {
+    static Sint16 in[65536 + MAX_OFFSET];
+    static float expected[65536], got[65536];
+
+    // Every value, including both ends of the range
+    for (int i = 0; i < 65536; i++) {
+        in[i] = (Sint16)(i - 32768);
+    }
+    convert_s16_to_f32_scalar(in, expected, 65536);
+    v->s16_to_f32(in, got, 65536);
+    compare(v->name, "s16", 65536, 0, expected, got);
+
+    for (size_t offset = 0; offset <= MAX_OFFSET; offset++) {
+        for (size_t c = 0; c < COUNT_COUNT; c++) {
+            for (size_t i = 0; i < counts[c]; i++) {
+                in[offset + i] = (Sint16)next_random();
+            }
+            convert_s16_to_f32_scalar(in + offset, expected + offset, counts[c]);
+            v->s16_to_f32(in + offset, got + offset, counts[c]);
+            compare(v->name, "s16", counts[c], offset, expected + offset, got + offset);
+        }
+    }
+}
+
+static void test_s32(const Variant *v) {
+    static Sint32 in[MAX_COUNT + MAX_OFFSET];
+    static float expected[MAX_COUNT + MAX_OFFSET], got[MAX_COUNT + MAX_OFFSET];
+
+    for (size_t offset = 0; offset <= MAX_OFFSET; offset++) {
+        for (size_t c = 0; c < COUNT_COUNT; c++) {
+            for (size_t i = 0; i < counts[c]; i++) {
+                const Uint32 r = next_random();
+                in[offset + i] = r % 7 == 0 ? SDL_MIN_SINT32
+                               : r % 7 == 1 ? SDL_MAX_SINT32
+                               : (Sint32)(r ^ (next_random() << 16));
+            }
+            convert_s32_to_f32_scalar(in + offset, expected + offset, counts[c]);
+            v->s32_to_f32(in + offset, got + offset, counts[c]);
+            compare(v->name, "s32", counts[c], offset, expected + offset, got + offset);
+        }
+    }
+}
+
+static void test_downmix(const Variant *v) {
+    static float in[(MAX_COUNT + MAX_OFFSET) * 3];
+    static float expected[MAX_COUNT + MAX_OFFSET], got[MAX_COUNT + MAX_OFFSET];
+
+    for (int channels = 1; channels <= 3; channels++) {
+        for (size_t offset = 0; offset <= MAX_OFFSET; offset++) {
+            for (size_t c = 0; c < COUNT_COUNT; c++) {
+                const size_t frames = counts[c];
+                for (size_t i = 0; i < frames * channels; i++) {
+                    in[offset + i] = random_sample();
+                }
+                convert_downmix_f32_scalar(in + offset, expected + offset, frames, channels);
+                v->downmix(in + offset, got + offset, frames, channels);
+                compare(v->name, channels == 2 ? "downmix" : "downmix (fallback)",
+                        frames, offset, expected + offset, got + offset);
+            }
+        }
+    }
+}
+
+// min and max must match exactly (a zero may differ in sign); the sum of
+// squares is added in another order, so it only has to be close
+static void test_peak(const Variant *v) {
+    static float in[MAX_COUNT + MAX_OFFSET];
+
+    for (int nan_first = 0; nan_first <= 1; nan_first++) {
+        for (size_t offset = 0; offset <= MAX_OFFSET; offset++) {
+            for (size_t c = 0; c < COUNT_COUNT; c++) {
+                const size_t count = counts[c];
+                if (count == 0) continue;
+                for (size_t i = 0; i < count; i++) {
+                    in[offset + i] = random_sample();
+                }
+                in[offset] = nan_first ? NAN : 0.25f;
+
+                float min[2], max[2], sum[2];
+                convert_peak_f32_scalar(in + offset, count, &min[0], &max[0], &sum[0]);
+                v->peak(in + offset, count, &min[1], &max[1], &sum[1]);
+                if (!(min[0] == min[1] || (isnan(min[0]) && isnan(min[1])))) {
+                    fail(v->name, "peak min", count, offset, 0, min[0], min[1]);
+                }
+                if (!(max[0] == max[1] || (isnan(max[0]) && isnan(max[1])))) {
+                    fail(v->name, "peak max", count, offset, 0, max[0], max[1]);
+                }
+                const bool sum_ok = isnan(sum[0]) || isinf(sum[0])
+                    ? same_float(sum[0], sum[1])
+                    : fabsf(sum[0] - sum[1]) <= 1e-5f * fabsf(sum[0]) + 1e-30f;
+                if (!sum_ok) {
+                    fail(v->name, "peak sum", count, offset, 0, sum[0], sum[1]);
+                }
+            }
+        }
+    }
+}
+
+// The dispatched decimator, whichever kernel it lands on, against the plain
+// definition: the sum of each run in order, times 1/factor
+static void test_decimate(void) {
+    static float in[(MAX_COUNT + MAX_OFFSET) * 4];
+    static float expected[MAX_COUNT + MAX_OFFSET], got[MAX_COUNT + MAX_OFFSET];
+
+    for (int factor = 1; factor <= 4; factor++) {
+        const float scale = 1.0f / (float)factor;
+        for (size_t offset = 0; offset <= MAX_OFFSET; offset++) {
+            for (size_t c = 0; c < COUNT_COUNT; c++) {
+                const size_t count = counts[c];
+                for (size_t i = 0; i < count * factor; i++) {
+                    in[offset + i] = random_sample();
+                }
+                for (size_t i = 0; i < count; i++) {
+                    const float *run = in + offset + i * factor;
+                    float sum = run[0];
+                    for (int j = 1; j < factor; j++) {
+                        sum += run[j];
+                    }
+                    expected[offset + i] = sum * scale;
+                }
+                convert_decimate_f32(in + offset, got + offset, count, factor);
+                compare(convert_get_backend(), "decimate", count, offset,
+                        expected + offset, got + offset);
+            }
+        }
+    }
+}
+
+int main(void) {
+    int tested = 0;
+    for (const Variant *v = variants; v->name; v++) {
+        if (!v->supported()) {
+            printf("skip %s: not supported by this CPU\n", v->name);
+            continue;
+        }
+        test_s16(v);
+        test_s32(v);
+        test_downmix(v);
+        test_peak(v);
+        printf("checked %s\n", v->name);
+        tested++;
+    }
+    if (tested == 0) {
+        printf("no SIMD variants built or supported; nothing to compare\n");
+    }
+
+    convert_init();
+    test_decimate();
+    printf("checked decimate (%s)\n", convert_get_backend());
+
+    if (failures > 0) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    return 0;
+}